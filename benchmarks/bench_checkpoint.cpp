@@ -0,0 +1,202 @@
+#include "core/rng.h"
+#include "io/checkpoint.h"
+#include "io/delta_checkpoint.h"
+#include "nn/activations.h"
+#include "nn/dense.h"
+#include "nn/losses.h"
+#include "nn/sequential.h"
+#include "optim/adam.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace tf;
+
+enum class Mode { None, Sync, Async };
+
+// Runs `steps` Adam steps, checkpointing every `every` steps, and prints the
+// distribution of per-step wall time (the save is charged to its step).
+// Only the head is trained (frozen backbone), so a step is cheap next to a
+// save of the whole model and the cost of checkpointing is plainly visible.
+void run(const char* label, Mode mode, int width, int batch, int steps, int every) {
+    RNG rng(1337);
+    Sequential model;
+    model.add(new Dense(width, width, rng));
+    model.add(new ReLU());
+    model.add(new Dense(width, width, rng));
+    model.add(new ReLU());
+    model.add(new Dense(width, 10, rng));
+
+    Tensor x(batch, width);
+    x.fill_(0.5f);
+    Tensor y(batch, 10);
+    for (int i = 0; i < batch; ++i) y(i, i % 10) = 1.0f;
+
+    Module* head = model.modules().back();
+    auto ps = head->params();
+    Adam optim(0.001f);
+    AsyncCheckpointWriter writer;
+    const std::string path = "bench_checkpoint.tnn";
+
+    std::vector<double> ms;
+    double save_steps_ms = 0.0;
+    auto total_start = std::chrono::high_resolution_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        Tensor logits = model.forward(x);
+        Tensor d_logits;
+        mse_loss(logits, y, d_logits);
+        optim.zero_grad(ps);
+        head->backward(d_logits);
+        optim.step(ps);
+        if (s % every == every - 1) {
+            if (mode == Mode::Sync) save_checkpoint(model, path);
+            if (mode == Mode::Async) writer.save(model, path);
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+        ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        if (s % every == every - 1) save_steps_ms += ms.back();
+    }
+    writer.wait();
+    double total = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - total_start).count();
+
+    std::sort(ms.begin(), ms.end());
+    auto pct = [&](double p) { return ms[std::min(ms.size() - 1, (size_t)(p * ms.size()))]; };
+    std::cout << std::fixed << std::setprecision(2)
+              << "[BENCH] " << std::left << std::setw(18) << label
+              << " p50 " << std::setw(8) << pct(0.50)
+              << " p90 " << std::setw(8) << pct(0.90)
+              << " max " << std::setw(8) << ms.back()
+              << " ckpt steps " << std::setw(8) << save_steps_ms / (steps / every)
+              << " total " << total << " ms" << std::endl;
+    std::remove(path.c_str());
+}
+
+// Snapshot size and write time, full save_checkpoint vs. delta chain, when
+// only the last `trained` of `layers` Dense layers are updated between
+// snapshots (fine-tuning a head, frozen backbone).
+void run_delta(int width, int layers, int trained, int snapshots) {
+    RNG rng(1337);
+    Sequential model;
+    for (int l = 0; l < layers; ++l) {
+        model.add(new Dense(width, l + 1 == layers ? 10 : width, rng));
+        if (l + 1 < layers) model.add(new ReLU());
+    }
+    auto all = model.params();
+    // Dense layers contribute W and b, ReLUs nothing.
+    std::vector<Param> ps(all.end() - 2 * trained, all.end());
+
+    Tensor x(8, width);
+    x.fill_(0.5f);
+    Tensor y(8, 10);
+    for (int i = 0; i < 8; ++i) y(i, i % 10) = 1.0f;
+    Adam optim(0.001f);
+
+    DeltaCheckpointWriter delta;
+    double full_ms = 0, delta_ms = 0;
+    size_t full_bytes = 0, delta_bytes = 0;
+    for (int snap = 0; snap < snapshots; ++snap) {
+        for (int step = 0; step < 2; ++step) {
+            optim.zero_grad(all);
+            Tensor logits = model.forward(x);
+            Tensor d_logits;
+            mse_loss(logits, y, d_logits);
+            model.backward(d_logits);
+            optim.step(ps);
+        }
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        save_checkpoint(model, "bench_full.tnn");
+        auto t1 = std::chrono::high_resolution_clock::now();
+        DeltaStats st = delta.save(model, "bench_delta_" + std::to_string(snap) + ".tnn");
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        std::FILE* f = std::fopen("bench_full.tnn", "rb");
+        std::fseek(f, 0, SEEK_END);
+        size_t fb = (size_t)std::ftell(f);
+        std::fclose(f);
+        if (snap > 0) { // the first delta snapshot is the full base
+            full_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+            delta_ms += std::chrono::duration<double, std::milli>(t2 - t1).count();
+            full_bytes += fb;
+            delta_bytes += st.bytes_written;
+        }
+    }
+    const int n = snapshots - 1;
+    std::cout << std::fixed << std::setprecision(2)
+              << "[BENCH] " << trained << "/" << layers << " layers trained:"
+              << " full " << full_bytes / n / 1024 << " KiB " << full_ms / n << " ms"
+              << " | delta " << delta_bytes / n / 1024 << " KiB " << delta_ms / n << " ms"
+              << " (per snapshot)" << std::endl;
+
+    compact_checkpoint("bench_delta_" + std::to_string(snapshots - 1) + ".tnn", "bench_compact.tnn");
+    Sequential check;
+    RNG rng2(1);
+    for (int l = 0; l < layers; ++l) {
+        check.add(new Dense(width, l + 1 == layers ? 10 : width, rng2));
+        if (l + 1 < layers) check.add(new ReLU());
+    }
+    load_checkpoint(check, "bench_compact.tnn");
+    auto a = model.params(), b = check.params();
+    for (size_t i = 0; i < a.size(); ++i)
+        if (std::memcmp(a[i].value->data.data(), b[i].value->data.data(),
+                        a[i].value->size() * sizeof(float)) != 0) std::cout << "  [WARN] compacted snapshot differs" << std::endl;
+
+    std::remove("bench_full.tnn");
+    std::remove("bench_compact.tnn");
+    for (int snap = 0; snap < snapshots; ++snap)
+        std::remove(("bench_delta_" + std::to_string(snap) + ".tnn").c_str());
+}
+
+// File size and (page-cache warm) load time per weight storage dtype.
+void run_storage(int width, int layers) {
+    RNG rng(1337);
+    Sequential model;
+    for (int l = 0; l < layers; ++l) model.add(new Dense(width, width, rng));
+
+    const DType dtypes[] = {DType::F32, DType::F16, DType::BF16, DType::I8};
+    for (DType dt : dtypes) {
+        CheckpointStorage storage;
+        storage.matrices = dt;
+        save_checkpoint(model, "bench_storage.tnn", storage);
+        std::FILE* f = std::fopen("bench_storage.tnn", "rb");
+        std::fseek(f, 0, SEEK_END);
+        size_t bytes = (size_t)std::ftell(f);
+        std::fclose(f);
+
+        load_checkpoint(model, "bench_storage.tnn"); // warm the page cache
+        const int reps = 5;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < reps; ++r) load_checkpoint(model, "bench_storage.tnn");
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - t0).count() / reps;
+        std::cout << std::fixed << std::setprecision(2) << "[BENCH] " << std::setw(4)
+                  << dtype_name(dt) << " weights: " << bytes / (1 << 20) << " MiB, load "
+                  << ms << " ms" << std::endl;
+    }
+    std::remove("bench_storage.tnn");
+}
+
+int main() {
+    const int width = 2048, batch = 4, steps = 200, every = 20;
+    size_t params = (size_t)width * width * 2 + (size_t)width * 10;
+    std::cout << "--- step time (ms), " << params * 4 / (1 << 20) << " MiB of parameters, "
+              << "head-only steps, checkpoint every " << every << " steps ---" << std::endl;
+    run("no checkpoint", Mode::None, width, batch, steps, every);
+    run("sync save", Mode::Sync, width, batch, steps, every);
+    run("async save", Mode::Async, width, batch, steps, every);
+
+    std::cout << "--- delta vs. full snapshots (4 x Dense(1024), 2 steps between snapshots) ---" << std::endl;
+    run_delta(1024, 4, 1, 6);
+    run_delta(1024, 4, 2, 6);
+    run_delta(1024, 4, 4, 6);
+
+    std::cout << "--- storage dtypes (4 x Dense(2048)) ---" << std::endl;
+    run_storage(2048, 4);
+    return 0;
+}
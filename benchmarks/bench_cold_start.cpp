@@ -0,0 +1,101 @@
+#include "core/rng.h"
+#include "io/checkpoint.h"
+#include "nn/activations.h"
+#include "nn/dense.h"
+#include "nn/inference.h"
+#include "nn/sequential.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace tf;
+
+// Drops the file's clean pages from the page cache so the next open reads
+// from disk (no root needed). No-op where posix_fadvise is unavailable.
+static void evict(const std::string& path) {
+#if defined(__linux__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#else
+    (void)path;
+#endif
+}
+
+static void build(Sequential& model, const std::vector<int>& widths, uint64_t seed) {
+    RNG rng(seed);
+    for (size_t l = 0; l + 1 < widths.size(); ++l) {
+        model.add(new Dense(widths[l], widths[l + 1], rng));
+        if (l + 2 < widths.size()) model.add(new ReLU());
+    }
+}
+
+// Median over reps of start-to-first-prediction time.
+static double median_ms(int reps, const std::function<void()>& before, const std::function<void()>& run) {
+    std::vector<double> ms;
+    for (int r = 0; r < reps; ++r) {
+        before();
+        auto t0 = std::chrono::high_resolution_clock::now();
+        run();
+        ms.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - t0).count());
+    }
+    std::sort(ms.begin(), ms.end());
+    return ms[ms.size() / 2];
+}
+
+void bench_cold_start(const std::string& label, const std::vector<int>& widths) {
+    Sequential model;
+    build(model, widths, 1337);
+    const std::string ckpt = "bench_cold_ckpt.tnn", bundle = "bench_cold_bundle.tnn";
+    save_checkpoint(model, ckpt);
+    export_inference(model, bundle);
+
+    Tensor x(1, widths.front(), 0.5f);
+    float sink = 0.0f;
+
+    auto rebuild = [&] {
+        Sequential m;
+        build(m, widths, 7);
+        load_checkpoint(m, ckpt);
+        sink += m.forward(x).data[0];
+    };
+    auto mapped = [&](bool verify) {
+        InferenceModel m(bundle, verify);
+        sink += m.forward(x).data[0];
+    };
+
+    std::cout << "--- " << label << " ---" << std::endl;
+    const int reps = 5;
+    for (int cold = 1; cold >= 0; --cold) {
+        auto before = [&] { if (cold) { evict(ckpt); evict(bundle); } };
+        double a = median_ms(reps, before, rebuild);
+        double b = median_ms(reps, before, [&] { mapped(true); });
+        double c = median_ms(reps, before, [&] { mapped(false); });
+        std::cout << std::fixed << std::setprecision(2)
+                  << "[BENCH] " << (cold ? "cold" : "warm")
+                  << " | Sequential + load_checkpoint + forward: " << a << " ms"
+                  << " | InferenceModel + forward: " << b << " ms (verify), "
+                  << c << " ms (no verify)" << std::endl;
+    }
+    if (sink == -1.0f) std::cout << "impossible";
+    std::remove(ckpt.c_str());
+    std::remove(bundle.c_str());
+}
+
+int main() {
+    bench_cold_start("bench_mlp topology 784-512-256-10", {784, 512, 256, 10});
+    bench_cold_start("large 784-4096-4096-10", {784, 4096, 4096, 10});
+    return 0;
+}
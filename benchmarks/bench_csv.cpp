@@ -0,0 +1,98 @@
+#include "core/rng.h"
+#include "data/csv.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tf;
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void report(const std::string& name, size_t bytes, size_t rows, double secs) {
+    std::cout << "[BENCH] " << name << ": " << (size_t)(secs * 1000.0) << " ms | "
+              << (size_t)(bytes / secs / 1e6) << " MB/s | " << rows << " rows" << std::endl;
+}
+
+// What callers did before: getline + stringstream per field.
+static size_t read_with_iostreams(const std::string& path, int cols) {
+    std::ifstream in(path);
+    std::string line, field;
+    std::getline(in, line);
+    std::vector<float> xs, ys;
+    size_t rows = 0;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        for (int c = 0; c < cols; ++c) {
+            std::getline(ss, field, ',');
+            float v = std::stof(field);
+            if (c + 1 < cols) xs.push_back(v);
+            else ys.push_back(v);
+        }
+        ++rows;
+    }
+    return rows;
+}
+
+int main() {
+    const std::string path = "bench_csv.csv";
+    const std::string bin = "bench_csv.tnds";
+    const int rows = 200000;
+    const int features = 32;
+    const int classes = 10;
+
+    {
+        RNG rng(1);
+        std::ofstream out(path);
+        for (int j = 0; j < features; ++j) out << "f" << j << ",";
+        out << "label\n";
+        char buf[32];
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < features; ++j) {
+                std::snprintf(buf, sizeof(buf), "%.6g,", rng.uniform(-100.0f, 100.0f));
+                out << buf;
+            }
+            out << (int)(rng.next_u32() % classes) << "\n";
+        }
+    }
+    size_t bytes = 0;
+    {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        bytes = (size_t)in.tellg();
+    }
+    std::cout << "--- " << rows << " rows x " << features + 1 << " columns, " << bytes / (1 << 20)
+              << " MiB ---" << std::endl;
+
+    auto t0 = std::chrono::steady_clock::now();
+    size_t n = read_with_iostreams(path, features + 1);
+    report("iostream getline + stof", bytes, n, seconds_since(t0));
+
+    CsvOptions opts;
+    opts.num_classes = classes;
+
+    opts.num_threads = 1;
+    t0 = std::chrono::steady_clock::now();
+    n = read_csv(path, opts).size();
+    report("read_csv 1 thread", bytes, n, seconds_since(t0));
+
+    opts.num_threads = 0;
+    t0 = std::chrono::steady_clock::now();
+    n = read_csv(path, opts).size();
+    report("read_csv " + std::to_string(std::thread::hardware_concurrency()) + " threads", bytes,
+           n, seconds_since(t0));
+
+    opts.chunk_bytes = 4u << 20;
+    t0 = std::chrono::steady_clock::now();
+    n = csv_to_binary(path, bin, opts);
+    report("csv_to_binary (4 MiB chunks)", bytes, n, seconds_since(t0));
+
+    std::remove(path.c_str());
+    std::remove(bin.c_str());
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "data/compact_dataset.h"
+#include "data/dataloader.h"
+#include "data/toy_datasets.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace tf;
+
+// Stands in for decoding / feature transforms: every get() runs a few
+// hundred transcendental ops per feature before returning the row.
+struct ExpensiveDataset : Dataset {
+    TensorDataset inner;
+    int work;
+
+    ExpensiveDataset(TensorDataset ds, int work) : inner(std::move(ds)), work(work) {}
+
+    size_t size() const override { return inner.size(); }
+
+    Sample get(size_t i) const override {
+        Sample s = inner.get(i);
+        for (auto& v : s.x.data) {
+            float acc = v;
+            for (int k = 0; k < work; ++k) acc = std::sin(acc) + 0.5f * v;
+            v = acc;
+        }
+        return s;
+    }
+};
+
+static double run_epoch(DataLoader& loader, int epochs) {
+    Tensor X, Y;
+    double checksum = 0.0;
+    for (int e = 0; e < epochs; ++e) {
+        while (loader.next(X, Y)) checksum += X.data[0];
+        loader.reset();
+    }
+    return checksum;
+}
+
+static void bench_workers(Dataset& ds, size_t batch, int epochs, size_t workers) {
+    LoaderOptions opts;
+    opts.num_workers = workers;
+    opts.prefetch = workers == 0 ? 0 : 2 * workers;
+    DataLoader loader(ds, batch, opts);
+    run_epoch(loader, 1); // warm buffers and threads
+    loader.reset_stats();
+
+    auto t0 = std::chrono::steady_clock::now();
+    double checksum = run_epoch(loader, epochs);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const LoaderStats& st = loader.stats();
+    std::cout << "workers " << workers << " | " << (size_t)(st.batches / secs)
+              << " batches/s | stalls " << st.stalls << "/" << st.batches << " ("
+              << st.stall_seconds * 1000.0 << " ms) | checksum " << checksum << std::endl;
+}
+
+int main() {
+    const int samples = 8192;
+    const int features = 32;
+    const size_t batch = 64;
+    const int epochs = 3;
+
+    ExpensiveDataset ds(make_blobs(samples, features, 10), 200);
+    std::cout << "--- expensive dataset: " << samples << " x " << features << ", batch " << batch
+              << ", " << epochs << " epochs ---" << std::endl;
+    for (size_t w : {0, 1, 2, 4, 8}) bench_workers(ds, batch, epochs, w);
+
+    TensorDataset cheap = make_blobs(1 << 16, 256, 10);
+    std::cout << "--- in-memory TensorDataset: " << cheap.size() << " x 256, batch 256 ---"
+              << std::endl;
+    for (size_t w : {0, 1, 2}) bench_workers(cheap, 256, epochs, w);
+
+    std::cout << "--- compact feature storage, shuffled, synchronous ---" << std::endl;
+    for (DType dt : {DType::F16, DType::I16, DType::U8}) {
+        CompactDataset cd = CompactDataset::quantize(cheap.features(), cheap.targets(), dt);
+        std::cout << dtype_name(dt) << ": " << cd.feature_bytes() / (1 << 20) << " MiB features (f32 "
+                  << cheap.features().size() * sizeof(float) / (1 << 20) << " MiB)" << std::endl;
+        bench_workers(cd, 256, epochs, 0);
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "core/rng.h"
+#include "nn/activations.h"
+#include "nn/dense.h"
+#include "nn/inference.h"
+#include "nn/sequential.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace tf;
+
+// Per-request latency of small-batch forward passes, as an online scorer
+// sees them: each call timed on its own, reported as p50 / p99.
+static void report(const std::string& label, int iters, const std::function<void()>& run) {
+    for (int i = 0; i < iters / 10; ++i) run(); // warm caches and the thread pool
+    std::vector<double> us(iters);
+    for (int i = 0; i < iters; ++i) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        run();
+        us[i] = std::chrono::duration<double, std::micro>(
+            std::chrono::high_resolution_clock::now() - t0).count();
+    }
+    std::sort(us.begin(), us.end());
+    std::cout << std::fixed << std::setprecision(1)
+              << "[BENCH] " << std::left << std::setw(38) << label << std::right
+              << " p50 " << std::setw(7) << us[iters / 2] << " us"
+              << " | p99 " << std::setw(7) << us[iters * 99 / 100] << " us" << std::endl;
+}
+
+void bench_latency(int batch, int iters) {
+    std::cout << "--- forward latency, 784-512-256-10 (batch=" << batch << ") ---" << std::endl;
+
+    RNG rng(1337);
+    Sequential model;
+    model.add(new Dense(784, 512, rng));
+    model.add(new ReLU());
+    model.add(new Dense(512, 256, rng));
+    model.add(new ReLU());
+    model.add(new Dense(256, 10, rng));
+
+    const std::string bundle = "bench_latency_bundle.tnn";
+    export_inference(model, bundle);
+    InferenceModel inf(bundle);
+
+    Tensor x(batch, 784);
+    for (auto& v : x.data) v = rng.uniform(0.0f, 1.0f);
+    float sink = 0.0f;
+
+    model.set_training(true);
+    report("Sequential, training mode", iters, [&] { sink += model.forward(x).data[0]; });
+    model.set_training(false);
+    report("Sequential, inference mode (fused)", iters, [&] { sink += model.forward(x).data[0]; });
+    report("InferenceModel bundle (fused)", iters, [&] { sink += inf.forward(x).data[0]; });
+
+    if (sink == -1.0f) std::cout << "impossible";
+    std::remove(bundle.c_str());
+}
+
+int main() {
+    bench_latency(1, 2000);
+    bench_latency(4, 2000);
+    bench_latency(16, 1000);
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include "utils/timer.h"
+#include "nn/activations.h"
 #include "nn/dense.h"
 #include "nn/losses.h"
+#include "nn/sequential.h"
+#include "optim/adam.h"
 #include "core/rng.h"
 #include "core/math.h"
 #include <iostream>
@@ -65,8 +68,81 @@ void bench_mlp_training(int batch_size, int epochs) {
     }
 }
 
+// Adam training steps on the same topology: zero_grad + backward + step
+// versus the optimizer-in-backward path (Sequential::backward_step).
+void bench_fused_step(int batch_size, int steps) {
+    std::cout << "--- bench adam step (batch=" << batch_size << ", steps=" << steps << ") ---" << std::endl;
+
+    RNG rng(1337);
+    Sequential model;
+    model.add(new Dense(784, 512, rng));
+    model.add(new ReLU());
+    model.add(new Dense(512, 256, rng));
+    model.add(new ReLU());
+    model.add(new Dense(256, 10, rng));
+
+    Tensor x(batch_size, 784);
+    x.fill_(0.5f);
+    Tensor y_target(batch_size, 10);
+    for(int i=0; i<batch_size; ++i) y_target(i, i%10) = 1.0f;
+
+    auto ps = model.params();
+    Adam optim(0.001f);
+
+    {
+        bench::Timer t("separate zero_grad/backward/step");
+        for (int s = 0; s < steps; ++s) {
+            optim.zero_grad(ps);
+            Tensor logits = model.forward(x);
+            Tensor d_logits;
+            mse_loss(logits, y_target, d_logits);
+            model.backward(d_logits);
+            optim.step(ps);
+        }
+    }
+    {
+        bench::Timer t("fused backward_step");
+        for (int s = 0; s < steps; ++s) {
+            Tensor logits = model.forward(x);
+            Tensor d_logits;
+            mse_loss(logits, y_target, d_logits);
+            model.backward_step(d_logits, optim);
+        }
+    }
+}
+
+// Forward passes in training mode (W repacked every call, inputs cached for
+// backward) versus inference mode (W packed once and reused).
+void bench_eval_forward(int batch_size, int iters) {
+    std::cout << "--- bench forward (batch=" << batch_size << ", iters=" << iters << ") ---" << std::endl;
+
+    RNG rng(1337);
+    Sequential model;
+    model.add(new Dense(784, 512, rng));
+    model.add(new ReLU());
+    model.add(new Dense(512, 256, rng));
+    model.add(new ReLU());
+    model.add(new Dense(256, 10, rng));
+
+    Tensor x(batch_size, 784);
+    x.fill_(0.5f);
+
+    {
+        bench::Timer t("training-mode forward");
+        for (int i = 0; i < iters; ++i) model.forward(x);
+    }
+    model.set_training(false);
+    {
+        bench::Timer t("inference-mode forward (pre-packed W)");
+        for (int i = 0; i < iters; ++i) model.forward(x);
+    }
+}
+
 int main() {
     bench_mlp_training(64, 10); 
     bench_mlp_training(64, 50); 
+    bench_fused_step(64, 50);
+    bench_eval_forward(1, 500);
+    bench_eval_forward(64, 100);
     return 0;
 }
@@ -0,0 +1,136 @@
+#include "utils/timer.h"
+#include "core/rng.h"
+#include "core/tensor.h"
+#include "optim/adam.h"
+#include "optim/adam8bit.h"
+#include "optim/sgd.h"
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+using namespace tf;
+
+// Previous Adam: per-tensor hash-map state and a scalar loop that divides by
+// the bias corrections per element. Kept here as the baseline.
+struct ReferenceAdam {
+    float lr = 0.001f, beta1 = 0.9f, beta2 = 0.999f, eps = 1e-8f;
+    int t = 0;
+    std::unordered_map<Tensor*, Tensor> m, v;
+
+    void step(const std::vector<Param>& ps) {
+        t++;
+        float c1 = 1.0f - std::pow(beta1, t);
+        float c2 = 1.0f - std::pow(beta2, t);
+        for (const auto& p : ps) {
+            if (m.find(p.value) == m.end()) {
+                m[p.value] = Tensor(p.value->rows, p.value->cols, 0.0f);
+                v[p.value] = Tensor(p.value->rows, p.value->cols, 0.0f);
+            }
+            Tensor& mt = m[p.value];
+            Tensor& vt = v[p.value];
+            for (size_t i = 0; i < p.value->size(); ++i) {
+                float g = p.grad->data[i];
+                mt.data[i] = beta1 * mt.data[i] + (1.0f - beta1) * g;
+                vt.data[i] = beta2 * vt.data[i] + (1.0f - beta2) * g * g;
+                float m_hat = mt.data[i] / c1;
+                float v_hat = vt.data[i] / c2;
+                p.value->data[i] -= lr * m_hat / (std::sqrt(v_hat) + eps);
+            }
+        }
+    }
+};
+
+// Dense layer shapes (W and b) of an MLP with the given widths.
+static void make_params(const std::vector<int>& widths, std::vector<Tensor>& values,
+                        std::vector<Tensor>& grads) {
+    RNG rng(7);
+    for (size_t l = 0; l + 1 < widths.size(); ++l) {
+        values.emplace_back(widths[l], widths[l + 1]);
+        values.emplace_back(1, widths[l + 1]);
+    }
+    for (auto& v : values) {
+        for (auto& x : v.data) x = rng.uniform(-0.1f, 0.1f);
+        grads.emplace_back(v.rows, v.cols);
+        for (auto& x : grads.back().data) x = rng.uniform(-1.0f, 1.0f);
+    }
+}
+
+void bench_adam(const std::string& label, const std::vector<int>& widths, int steps) {
+    std::vector<Tensor> values, grads;
+    make_params(widths, values, grads);
+
+    std::vector<Param> ps;
+    size_t count = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        ps.push_back({&values[i], &grads[i]});
+        count += values[i].size();
+    }
+
+    std::cout << "--- " << label << ": " << count << " params, " << ps.size()
+              << " tensors, " << steps << " steps ---" << std::endl;
+
+    ReferenceAdam ref;
+    ref.step(ps); // allocate state outside the timed region
+    {
+        bench::Timer t("reference adam");
+        for (int s = 0; s < steps; ++s) ref.step(ps);
+    }
+
+    Adam adam;
+    adam.step(ps);
+    {
+        bench::Timer t("fused adam");
+        for (int s = 0; s < steps; ++s) adam.step(ps);
+    }
+
+    Adam adamw(0.001f, 0.9f, 0.999f, 1e-8f, 0.01f);
+    adamw.step(ps);
+    {
+        bench::Timer t("fused adamw");
+        for (int s = 0; s < steps; ++s) adamw.step(ps);
+    }
+
+    Adam8bit adam8;
+    adam8.step(ps);
+    {
+        bench::Timer t("adam 8-bit state");
+        for (int s = 0; s < steps; ++s) adam8.step(ps);
+    }
+
+    std::cout << "state: adam " << adam.state_bytes() / 1024 << " KiB | adam 8-bit "
+              << adam8.state_bytes() / 1024 << " KiB" << std::endl;
+}
+
+void bench_sgd(const std::string& label, const std::vector<int>& widths, int steps) {
+    std::vector<Tensor> values, grads;
+    make_params(widths, values, grads);
+
+    std::vector<Param> ps;
+    for (size_t i = 0; i < values.size(); ++i) ps.push_back({&values[i], &grads[i]});
+
+    std::cout << "--- " << label << ": sgd momentum 0.9 + nesterov + wd, " << steps
+              << " steps ---" << std::endl;
+
+    SGD sgd(0.01f, 0.9f, 1e-4f, true);
+    sgd.step(ps);
+    {
+        bench::Timer t("sgd step + separate zero_grad");
+        for (int s = 0; s < steps; ++s) {
+            sgd.step(ps);
+            sgd.zero_grad(ps);
+        }
+    }
+    {
+        bench::Timer t("sgd step with fused zero_grad");
+        for (int s = 0; s < steps; ++s) sgd.step(ps, true);
+    }
+}
+
+int main() {
+    bench_adam("bench_mlp topology", {784, 512, 256, 10}, 200);
+    bench_adam("wide mlp", {1024, 2048, 2048, 1024}, 20);
+    bench_adam("many small tensors", {64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64}, 2000);
+    bench_sgd("wide mlp", {1024, 2048, 2048, 1024}, 20);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "utils/timer.h"
+#include "core/rng.h"
+#include "data/toy_datasets.h"
+#include <iostream>
+#include <vector>
+
+using namespace tf;
+
+// The previous generator: a 32-bit LCG, one value at a time.
+struct LcgRNG {
+    unsigned int state;
+    explicit LcgRNG(unsigned int seed) : state(seed) {}
+    float uniform(float a, float b) {
+        state = 1664525u * state + 1013904223u;
+        return a + (b - a) * ((state >> 8) * (1.0f / 16777216.0f));
+    }
+};
+
+int main() {
+    const size_t n = 1 << 24;
+    std::vector<float> buf(n);
+    double sink = 0.0;
+
+    std::cout << "--- " << n << " floats ---" << std::endl;
+    {
+        LcgRNG rng(42);
+        bench::Timer t("lcg scalar uniform");
+        for (auto& v : buf) v = rng.uniform(-1.0f, 1.0f);
+    }
+    sink += buf[n / 2];
+    {
+        RNG rng(42);
+        bench::Timer t("philox scalar uniform");
+        for (auto& v : buf) v = rng.uniform(-1.0f, 1.0f);
+    }
+    sink += buf[n / 2];
+    {
+        RNG rng(42);
+        bench::Timer t("philox fill_uniform");
+        rng.fill_uniform(buf.data(), n, -1.0f, 1.0f);
+    }
+    sink += buf[n / 2];
+    {
+        RNG rng(42);
+        bench::Timer t("philox fill_normal");
+        rng.fill_normal(buf.data(), n);
+    }
+    sink += buf[n / 2];
+
+    std::cout << "--- init / synthesis ---" << std::endl;
+    {
+        Tensor W(4096, 4096);
+        RNG rng(1);
+        bench::Timer t("he_uniform_ 4096x4096");
+        he_uniform_(W, rng);
+        sink += W.data[7];
+    }
+    {
+        bench::Timer t("make_blobs 1M x 32");
+        auto ds = make_blobs(1 << 20, 32, 10);
+        sink += ds.features().data[0];
+    }
+
+    std::cout << "(checksum " << sink << ")" << std::endl;
+    return 0;
+}
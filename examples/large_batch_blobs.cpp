@@ -0,0 +1,109 @@
+#include "core/rng.h"
+#include "data/dataloader.h"
+#include "data/toy_datasets.h"
+#include "nn/activations.h"
+#include "nn/dense.h"
+#include "nn/losses.h"
+#include "nn/sequential.h"
+#include "optim/adam.h"
+#include "optim/lamb.h"
+#include "optim/lars.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace tf;
+
+static float accuracy(Sequential &model, const Tensor &X, const Tensor &Y) {
+  Tensor logits = model.forward(X);
+  int correct = 0;
+  for (int r = 0; r < logits.rows; ++r) {
+    int pred = 0, target = 0;
+    for (int c = 1; c < logits.cols; ++c) {
+      if (logits(r, c) > logits(r, pred))
+        pred = c;
+      if (Y(r, c) > Y(r, target))
+        target = c;
+    }
+    if (pred == target)
+      correct++;
+  }
+  return (float)correct / (float)logits.rows;
+}
+
+// Trains until training loss drops below target_loss (or max_epochs) and
+// reports how long it took.
+template <class Optim>
+static void run(const std::string &name, TensorDataset &dataset,
+                size_t batch_size, Optim &optim, float target_loss,
+                int max_epochs) {
+  RNG rng(42);
+  Sequential model;
+  model.add(new Dense(dataset.features().cols, 64, rng));
+  model.add(new ReLU());
+  model.add(new Dense(64, 64, rng));
+  model.add(new ReLU());
+  model.add(new Dense(64, dataset.targets().cols, rng));
+  auto params = model.params();
+
+  DataLoader loader(dataset, batch_size, true, 42);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  int epoch = 0, steps = 0;
+  float loss = 0.0f;
+  for (; epoch < max_epochs; ++epoch) {
+    float epoch_loss = 0.0f;
+    int batches = 0;
+    Tensor X, Y;
+    while (loader.next(X, Y)) {
+      optim.zero_grad(params);
+      Tensor logits = model.forward(X);
+      Tensor d_logits;
+      epoch_loss += softmax_cross_entropy_with_logits(logits, Y, d_logits);
+      model.backward(d_logits);
+      optim.step(params);
+      batches++;
+      steps++;
+    }
+    loader.reset();
+    loss = epoch_loss / batches;
+    if (loss < target_loss) {
+      epoch++;
+      break;
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  std::cout << name << " | batch " << batch_size << " | epochs " << epoch
+            << " | steps " << steps << " | loss " << loss << " | acc "
+            << accuracy(model, dataset.features(), dataset.targets())
+            << " | " << seconds << " s"
+            << (loss < target_loss ? "" : " (did not reach target)")
+            << std::endl;
+}
+
+int main() {
+  const int samples = 16384;
+  const float target_loss = 0.1f;
+  const int max_epochs = 40;
+
+  std::cout << "--- Large-batch training on blobs (target loss " << target_loss
+            << ") ---" << std::endl;
+  auto dataset = make_blobs(samples, 16, 6, 6.0f, 42);
+
+  // Baseline: small-batch Adam, then the same optimizer at 16x the batch
+  // size, then the layer-wise adaptive optimizers at 16x.
+  Adam adam(0.001f);
+  run("adam", dataset, 32, adam, target_loss, max_epochs);
+
+  Adam adam_large(0.001f);
+  run("adam", dataset, 512, adam_large, target_loss, max_epochs);
+
+  LAMB lamb(0.01f, 0.9f, 0.999f, 1e-6f, 0.01f);
+  run("lamb", dataset, 512, lamb, target_loss, max_epochs);
+
+  LARS lars(0.5f, 0.9f, 0.0f, 0.01f);
+  run("lars", dataset, 512, lars, target_loss, max_epochs);
+  return 0;
+}
@@ -0,0 +1,114 @@
+#include "core/rng.h"
+#include "data/dataloader.h"
+#include "data/toy_datasets.h"
+#include "nn/activations.h"
+#include "nn/dense.h"
+#include "nn/losses.h"
+#include "nn/sequential.h"
+#include "optim/adam.h"
+#include "optim/loss_scaler.h"
+#include <chrono>
+#include <iostream>
+
+using namespace tf;
+
+struct RunResult {
+  float final_loss;
+  float accuracy;
+  double seconds;
+  int skipped;
+};
+
+static float accuracy(Sequential &model, const Tensor &X, const Tensor &Y) {
+  Tensor logits = model.forward(X);
+  int correct = 0;
+  for (int r = 0; r < logits.rows; ++r) {
+    int pred = 0, target = 0;
+    for (int c = 1; c < logits.cols; ++c) {
+      if (logits(r, c) > logits(r, pred))
+        pred = c;
+      if (Y(r, c) > Y(r, target))
+        target = c;
+    }
+    if (pred == target)
+      correct++;
+  }
+  return (float)correct / (float)logits.rows;
+}
+
+static RunResult train(TensorDataset &dataset, Precision precision,
+                       int epochs) {
+  const int features = dataset.features().cols;
+  const int classes = dataset.targets().cols;
+
+  RNG rng(42);
+  Sequential model;
+  model.add(new Dense(features, 256, rng));
+  model.add(new ReLU());
+  model.add(new Dense(256, 256, rng));
+  model.add(new ReLU());
+  model.add(new Dense(256, classes, rng));
+  model.set_precision(precision);
+
+  DataLoader loader(dataset, 128, true, 42);
+  Adam optim(0.005f);
+  LossScaler scaler;
+  auto params = model.params();
+
+  RunResult result{0.0f, 0.0f, 0.0, 0};
+  auto start = std::chrono::high_resolution_clock::now();
+
+  for (int epoch = 0; epoch < epochs; ++epoch) {
+    float epoch_loss = 0.0f;
+    int batches = 0;
+
+    Tensor X, Y;
+    while (loader.next(X, Y)) {
+      optim.zero_grad(params);
+
+      Tensor logits = model.forward(X);
+      Tensor d_logits;
+      epoch_loss += softmax_cross_entropy_with_logits(logits, Y, d_logits);
+      batches++;
+
+      if (precision == Precision::BF16) {
+        scaler.scale_grad(d_logits);
+        model.backward(d_logits);
+        scaler.step(optim, params);
+      } else {
+        model.backward(d_logits);
+        optim.step(params);
+      }
+    }
+    loader.reset();
+    result.final_loss = epoch_loss / batches;
+  }
+
+  auto end = std::chrono::high_resolution_clock::now();
+  result.seconds = std::chrono::duration<double>(end - start).count();
+  result.accuracy = accuracy(model, dataset.features(), dataset.targets());
+  result.skipped = scaler.skipped_steps();
+  return result;
+}
+
+int main() {
+  const int samples = 4000;
+  const int features = 64;
+  const int classes = 8;
+  const int epochs = 5;
+
+  std::cout << "--- Mixed precision (bf16) vs fp32 on blobs ---" << std::endl;
+  auto dataset = make_blobs(samples, features, classes, 12.0f, 42);
+
+  RunResult fp32 = train(dataset, Precision::FP32, epochs);
+  RunResult bf16 = train(dataset, Precision::BF16, epochs);
+
+  std::cout << "fp32 | loss " << fp32.final_loss << " | acc " << fp32.accuracy
+            << " | " << fp32.seconds << " s | "
+            << (samples * epochs) / fp32.seconds << " samples/s" << std::endl;
+  std::cout << "bf16 | loss " << bf16.final_loss << " | acc " << bf16.accuracy
+            << " | " << bf16.seconds << " s | "
+            << (samples * epochs) / bf16.seconds << " samples/s"
+            << " | skipped steps " << bf16.skipped << std::endl;
+  return 0;
+}
@@ -2,12 +2,14 @@
 #include "core/tensor.h"
 #include "data/dataloader.h"
 #include "data/toy_datasets.h"
+#include "io/training_state.h"
 #include "nn/activations.h"
 #include "nn/dense.h"
 #include "nn/losses.h"
 #include "nn/sequential.h"
 #include "optim/adam.h"
 
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
@@ -164,67 +166,63 @@ int main(int argc, char** argv) {
 
   DataLoader train_loader(train_ds, batch_size, /*shuffle=*/true, /*seed=*/1337);
 
-  std::cout << "\n[Stage 1] Training for " << epochs_before << " epochs...\n";
-  for (int ep = 1; ep <= epochs_before; ++ep) {
+  auto run_epoch = [&](Sequential& m, Adam& opt, DataLoader& loader,
+                       const std::vector<Param>& params, const char* tag, int ep) {
     float mean_loss = 0.0f;
-    train_one_epoch(model, optim, train_loader, ps, mean_loss);
+    train_one_epoch(m, opt, loader, params, mean_loss);
 
     float val_acc = 0.0f;
-    float val_loss = eval_loss_acc(model, val_ds.features(), val_ds.targets(), val_acc);
+    float val_loss = eval_loss_acc(m, val_ds.features(), val_ds.targets(), val_acc);
 
-    std::cout << "epoch " << ep
+    std::cout << tag << ep
               << " | train_loss " << mean_loss
               << " | val_loss " << val_loss
               << " | val_acc " << val_acc
               << "\n";
+  };
+
+  std::cout << "\n[Stage 1] Training for " << epochs_before << " epochs...\n";
+  for (int ep = 1; ep <= epochs_before; ++ep) {
+    run_epoch(model, optim, train_loader, ps, "epoch ", ep);
 
+    // Parameters, Adam moments/timestep, loader RNG and permutation, epoch.
     if (ep % 5 == 0 || ep == epochs_before) {
-      model.save(ckpt_path);
+      save_training_state(ckpt_path, model, optim, train_loader, ep);
       std::cout << "  [saved] " << ckpt_path << "\n";
     }
   }
 
-  float checksum_before = prediction_checksum(model, val_ds.features());
-  std::cout << "\n[Stage 1] checksum(val_logits) = " << checksum_before << "\n";
-
-  std::cout << "\n[Stage 2] Creating fresh model (different init), loading checkpoint...\n";
-  Sequential loaded = make_model(features, /*hidden=*/32, classes, /*seed=*/999);
-  loaded.load(ckpt_path);
+  // Reference: the uninterrupted run continues for epochs_after more epochs.
+  std::cout << "\n[Stage 1] Continuing without interruption for " << epochs_after << " epochs...\n";
+  for (int ep = epochs_before + 1; ep <= epochs_before + epochs_after; ++ep)
+    run_epoch(model, optim, train_loader, ps, "epoch ", ep);
 
-  float checksum_loaded = prediction_checksum(loaded, val_ds.features());
-  float diff = std::fabs(checksum_before - checksum_loaded);
+  float checksum_reference = prediction_checksum(model, val_ds.features());
+  std::cout << "[Stage 1] checksum(val_logits) = " << checksum_reference << "\n";
 
-  std::cout << "[Stage 2] checksum(val_logits) = " << checksum_loaded
-            << " | abs_diff = " << diff << "\n";
+  std::cout << "\n[Stage 2] Fresh model (different init), optimizer and loader; loading training state...\n";
+  Sequential loaded = make_model(features, /*hidden=*/32, classes, /*seed=*/999);
+  Adam optim2(0.01f);
+  DataLoader train_loader2(train_ds, batch_size, /*shuffle=*/true, /*seed=*/2024);
 
-  if (diff > 1e-3f) {
-    std::cout << "[WARN] checksum mismatch after load. Something is off.\n";
-  } else {
-    std::cout << "[OK] loaded model matches saved weights.\n";
-  }
+  auto t0 = std::chrono::steady_clock::now();
+  int start_epoch = load_training_state(ckpt_path, loaded, optim2, train_loader2);
+  double load_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - t0).count();
+  std::cout << "[Stage 2] restored epoch " << start_epoch << " in " << load_ms << " ms\n";
 
-  Adam optim2(0.01f);
   auto ps2 = loaded.params();
-  DataLoader train_loader2(train_ds, batch_size, /*shuffle=*/true, /*seed=*/1337);
-
   std::cout << "\n[Stage 2] Resuming training for " << epochs_after << " epochs...\n";
-  for (int ep = 1; ep <= epochs_after; ++ep) {
-    float mean_loss = 0.0f;
-    train_one_epoch(loaded, optim2, train_loader2, ps2, mean_loss);
+  for (int ep = start_epoch + 1; ep <= start_epoch + epochs_after; ++ep)
+    run_epoch(loaded, optim2, train_loader2, ps2, "resume_epoch ", ep);
 
-    float val_acc = 0.0f;
-    float val_loss = eval_loss_acc(loaded, val_ds.features(), val_ds.targets(), val_acc);
+  float checksum_resumed = prediction_checksum(loaded, val_ds.features());
+  std::cout << "[Stage 2] checksum(val_logits) = " << checksum_resumed << "\n";
 
-    std::cout << "resume_epoch " << ep
-              << " | train_loss " << mean_loss
-              << " | val_loss " << val_loss
-              << " | val_acc " << val_acc
-              << "\n";
-
-    if (ep % 5 == 0 || ep == epochs_after) {
-      loaded.save(ckpt_path);
-      std::cout << "  [saved] " << ckpt_path << "\n";
-    }
+  if (checksum_resumed != checksum_reference) {
+    std::cout << "[WARN] resumed run diverged from the uninterrupted one.\n";
+  } else {
+    std::cout << "[OK] resumed run is bit-identical to the uninterrupted one.\n";
   }
 
   std::cout << "\nDone.\n";
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace tf {
+
+enum class DType : uint32_t {
+  F32 = 0,
+  BF16 = 1,
+  U8 = 2,
+  F16 = 3,
+  I16 = 4,
+  I8 = 5,
+};
+
+size_t dtype_size(DType dt);
+const char *dtype_name(DType dt);
+
+// bfloat16: the upper 16 bits of an IEEE float. Conversions are done on the
+// bit pattern so they stay exact under -ffast-math.
+inline float bf16_to_f32(uint16_t h) {
+  uint32_t u = (uint32_t)h << 16;
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+inline uint16_t f32_to_bf16(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  if ((u & 0x7f800000u) == 0x7f800000u && (u & 0x007fffffu))
+    return (uint16_t)((u >> 16) | 0x0040u); // keep NaN quiet
+  u += 0x7fffu + ((u >> 16) & 1u);          // round to nearest even
+  return (uint16_t)(u >> 16);
+}
+
+// IEEE half precision, round to nearest even, on the bit pattern. Subnormal
+// halves decode exactly even with flush-to-zero enabled.
+inline float f16_to_f32(uint16_t h) {
+  // All three cases are computed and selected so the bulk loop vectorizes.
+  const uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+  const uint32_t em = h & 0x7fffu;
+  const uint32_t normal = (em << 13) + (112u << 23);
+  const uint32_t infnan = 0x7f800000u | ((em & 0x3ffu) << 13);
+  const float sub = (float)em * (1.0f / 16777216.0f); // exact
+  uint32_t subu;
+  std::memcpy(&subu, &sub, sizeof(subu));
+  const uint32_t u =
+      sign | (em >= 0x7c00u ? infnan : em >= 0x0400u ? normal : subu);
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+inline uint16_t f32_to_f16(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  const uint32_t sign = u & 0x80000000u;
+  u ^= sign;
+  uint16_t o;
+  if (u >= (143u << 23)) { // overflow, inf, nan
+    o = u > 0x7f800000u ? 0x7e00u : 0x7c00u;
+  } else if (u < (113u << 23)) { // result is subnormal or zero
+    const uint32_t magic_bits = 126u << 23; // 0.5
+    float m, t;
+    std::memcpy(&m, &magic_bits, sizeof(m));
+    std::memcpy(&t, &u, sizeof(t));
+    t += m; // rounds the mantissa at the half subnormal position
+    uint32_t tu;
+    std::memcpy(&tu, &t, sizeof(tu));
+    o = (uint16_t)(tu - magic_bits);
+  } else {
+    const uint32_t mant_odd = (u >> 13) & 1u;
+    u += (uint32_t)(15 - 127) * (1u << 23) + 0xfffu + mant_odd;
+    o = (uint16_t)(u >> 13);
+  }
+  return (uint16_t)(o | (sign >> 16));
+}
+
+// True for +-inf and NaN, checked on the bit pattern (std::isfinite is
+// folded away by -ffinite-math-only).
+inline bool is_nonfinite(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return (u & 0x7f800000u) == 0x7f800000u;
+}
+
+void f32_to_bf16(const float *src, uint16_t *dst, size_t n);
+void bf16_to_f32(const uint16_t *src, float *dst, size_t n);
+void f32_to_f16(const float *src, uint16_t *dst, size_t n);
+void f16_to_f32(const uint16_t *src, float *dst, size_t n);
+
+}  
@@ -1,16 +1,84 @@
 #pragma once
 #include "core/tensor.h"
+#include <cstdint>
+#include <vector>
 
 namespace tf {
 
 Tensor matmul(const Tensor &A, const Tensor &B);
+
+// GEMM right-hand side in the kernel's panel layout: column panels of
+// kGemmPanel columns, each stored k-major (rows() rows of kGemmPanel
+// contiguous floats), the last panel zero-padded. matmul() packs B on every
+// call; packing once and calling matmul_packed() skips that work.
+constexpr int kGemmPanel = 16;
+
+struct PackedMatrix {
+  int rows = 0; // K
+  int cols = 0; // N
+  Storage data; // rows * panels() * kGemmPanel floats; may be a view
+
+  int panels() const { return (cols + kGemmPanel - 1) / kGemmPanel; }
+  static size_t packed_size(int rows, int cols) {
+    return (size_t)rows * ((cols + kGemmPanel - 1) / kGemmPanel) * kGemmPanel;
+  }
+};
+
+// Elementwise activation fused into a GEMM epilogue.
+enum class Activation { None, ReLU, Sigmoid };
+
+// Reuses out.data when it is large enough.
+void pack_b(const Tensor &B, PackedMatrix &out);
+// C = A * B; C is resized in place (reusing its storage).
+void matmul_packed(const Tensor &A, const PackedMatrix &B, Tensor &C);
+// C = act(A * B + bias), applied while each output block is still in
+// registers. bias is (1, N) or empty.
+void matmul_packed(const Tensor &A, const PackedMatrix &B, const Tensor &bias,
+                   Activation act, Tensor &C);
+
+// Batches up to this many rows skip the repack of a changing B (Dense in
+// training mode) and go through matmul_skinny. Against an already packed B
+// the packed kernel is as fast at one row and faster from four.
+constexpr int kSkinnyRows = 16;
+
+// GEMV / skinny GEMM for batch-1 style inputs: C = act(A * B + bias) with
+// B read in place in its row-major layout, so nothing is packed and each
+// row of B is streamed once per pair of rows of A. Column blocks are split
+// across threads. bias is (1, N) or empty.
+void matmul_skinny(const Tensor &A, const Tensor &B, const Tensor &bias,
+                   Activation act, Tensor &C);
+// PackedMatrix with bfloat16 elements: same panel layout at half the bytes.
+struct PackedMatrixBF16 {
+  int rows = 0; // K
+  int cols = 0; // N
+  std::vector<uint16_t> data;
+
+  int panels() const { return (cols + kGemmPanel - 1) / kGemmPanel; }
+};
+
+// Packs B, rounded to bfloat16. Reuses out.data when it is large enough.
+void pack_b_bf16(const Tensor &B, PackedMatrixBF16 &out);
+// Packs B^T (B.cols x B.rows) without materializing the transpose.
+void pack_bt_bf16(const Tensor &B, PackedMatrixBF16 &out);
+// C = act(A * B + bias) with A given as M x K bfloat16 values; products are
+// accumulated in fp32 by the packed kernel.
+void matmul_packed_bf16(const uint16_t *A, int M, int K,
+                        const PackedMatrixBF16 &B, const Tensor &bias,
+                        Activation act, Tensor &C);
+// Operands rounded to bfloat16, products accumulated in fp32.
+Tensor matmul_bf16(const Tensor &A, const Tensor &B);
 Tensor transpose(const Tensor &A);
 Tensor add(const Tensor &A, const Tensor &B);
+void add_inplace(Tensor &A, const Tensor &B);
 Tensor sub(const Tensor &A, const Tensor &B);
 Tensor mul(const Tensor &A, const Tensor &B);
 Tensor mul_scalar(const Tensor &A, float s);
 
 Tensor add_bias_rowwise(const Tensor &X, const Tensor &b);
+// In-place variants for forward-only paths.
+void add_bias_rowwise_(Tensor &X, const Tensor &b);
+void relu_(Tensor &X);
+void sigmoid_(Tensor &X);
 Tensor sum_rows(const Tensor &X);
 
 Tensor relu(const Tensor &X);
@@ -1,15 +1,53 @@
 #pragma once
 #include "core/tensor.h"
+#include <cstdint>
 
 namespace tf {
 
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3"). Output block b of stream s is a pure
+// function of (seed, s, b), so any range of the sequence can be generated
+// independently: bulk fills run in parallel and give the same numbers for
+// any thread count, and split() yields statistically independent streams.
 struct RNG {
-  unsigned int state = 12345u;
-  explicit RNG(unsigned int seed = 12345u) : state(seed) {}
+  uint64_t key = 12345u;  // seed
+  uint64_t stream = 0;    // upper 64 bits of the counter
+  uint64_t block = 0;     // next block to generate (lower 64 bits)
+  uint32_t buf[4] = {0, 0, 0, 0};
+  uint32_t idx = 4;       // next unused word of buf; 4 = empty
 
-  inline unsigned int next_u32() {
-    state = 1664525u * state + 1013904223u;
-    return state;
+  explicit RNG(uint64_t seed = 12345u, uint64_t stream_id = 0)
+      : key(seed), stream(stream_id) {}
+
+  static inline void philox(uint64_t key, uint64_t stream, uint64_t block,
+                            uint32_t out[4]) {
+    uint32_t c0 = (uint32_t)block, c1 = (uint32_t)(block >> 32);
+    uint32_t c2 = (uint32_t)stream, c3 = (uint32_t)(stream >> 32);
+    uint32_t k0 = (uint32_t)key, k1 = (uint32_t)(key >> 32);
+    for (int r = 0; r < 10; ++r) {
+      const uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+      const uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+      const uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+      const uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+      c1 = (uint32_t)p1;
+      c3 = (uint32_t)p0;
+      c0 = n0;
+      c2 = n2;
+      k0 += 0x9E3779B9u;
+      k1 += 0xBB67AE85u;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+
+  inline uint32_t next_u32() {
+    if (idx >= 4) {
+      philox(key, stream, block++, buf);
+      idx = 0;
+    }
+    return buf[idx++];
   }
 
   inline float uniform01() {
@@ -19,6 +57,59 @@ struct RNG {
   inline float uniform(float a, float b) {
     return a + (b - a) * uniform01();
   }
+
+  // Unbiased integer in [0, n) (Lemire's multiply-and-reject).
+  inline uint32_t uniform_int(uint32_t n) {
+    uint64_t m = (uint64_t)next_u32() * n;
+    uint32_t low = (uint32_t)m;
+    if (low < n) {
+      const uint32_t threshold = (uint32_t)(-n) % n;
+      while (low < threshold) {
+        m = (uint64_t)next_u32() * n;
+        low = (uint32_t)m;
+      }
+    }
+    return (uint32_t)(m >> 32);
+  }
+
+  // Unbiased integer in [0, n) for 64-bit ranges. Ranges that fit 32 bits
+  // draw exactly like uniform_int; larger ones reject masked 64-bit words.
+  inline uint64_t uniform_int64(uint64_t n) {
+    if (n <= UINT32_MAX)
+      return uniform_int((uint32_t)n);
+    uint64_t mask = n - 1;
+    mask |= mask >> 1;
+    mask |= mask >> 2;
+    mask |= mask >> 4;
+    mask |= mask >> 8;
+    mask |= mask >> 16;
+    mask |= mask >> 32;
+    for (;;) {
+      const uint64_t hi = next_u32();
+      const uint64_t v = ((hi << 32) | next_u32()) & mask;
+      if (v < n)
+        return v;
+    }
+  }
+
+  float normal();
+
+  // Skip n blocks (4n values) ahead, dropping any buffered values.
+  void jump(uint64_t n) {
+    block += n;
+    idx = 4;
+  }
+
+  // Independent generator for sub-stream id of this one.
+  RNG split(uint64_t id) const {
+    return RNG(key, stream ^ (0x9E3779B97F4A7C15ull * (id + 1)));
+  }
+
+  // Bulk generation from the next unused block; advances past the blocks
+  // used. Large fills are split across threads without changing results.
+  void fill_uniform(float *dst, size_t n, float lo = 0.0f, float hi = 1.0f);
+  void fill_normal(float *dst, size_t n, float mean = 0.0f,
+                   float stddev = 1.0f);
 };
 
 void xavier_uniform_(Tensor& W, RNG& rng);
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+
+namespace tf {
+
+// Float buffer behind a Tensor.
+//
+// By default it owns 64-byte aligned memory and behaves like a
+// std::vector<float>. A storage can also be a view into memory owned
+// elsewhere (a parameter arena, a mapped file); views never free that
+// memory. Copy-constructing always produces an owning deep copy. Assigning
+// (copy or move) into a view writes through it, and resizing a view is
+// only allowed at its current size; both CHECK the size rather than detach.
+// rebind() is the one way to replace a view's memory or drop it.
+class Storage {
+public:
+  static constexpr size_t kAlignment = 64;
+
+  Storage() = default;
+  explicit Storage(size_t n, float fill = 0.0f);
+  ~Storage();
+
+  Storage(const Storage &other);
+  Storage &operator=(const Storage &other);
+  Storage(Storage &&other) noexcept;
+  Storage &operator=(Storage &&other);
+
+  // Takes over other's memory (owned or borrowed), dropping whatever this
+  // storage held. Unlike assignment this also replaces views.
+  void rebind(Storage &&other) noexcept;
+
+  static Storage view(float *ptr, size_t n);
+
+  float *data() { return ptr_; }
+  const float *data() const { return ptr_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  bool is_view() const { return !owns_ && ptr_ != nullptr; }
+
+  float &operator[](size_t i) { return ptr_[i]; }
+  const float &operator[](size_t i) const { return ptr_[i]; }
+
+  float *begin() { return ptr_; }
+  float *end() { return ptr_ + size_; }
+  const float *begin() const { return ptr_; }
+  const float *end() const { return ptr_ + size_; }
+
+  // Keeps the first min(size, n) elements, zero-fills the rest. Never
+  // reallocates when n fits the current capacity. A view must keep its size.
+  void resize(size_t n);
+  void clear();
+
+private:
+  void release();
+
+  float *ptr_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+  bool owns_ = true;
+};
+
+float *aligned_alloc_floats(size_t n);
+void aligned_free_floats(float *p);
+
+}  
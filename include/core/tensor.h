@@ -1,5 +1,6 @@
 #pragma once
 #include "core/error.h"
+#include "core/storage.h"
 #include <cassert>
 #include <cstddef>
 #include <string>
@@ -10,17 +11,23 @@ namespace tf {
 struct Tensor {
   int rows = 0;
   int cols = 0;
-  std::vector<float> data;
+  Storage data;
 
   Tensor() = default;
   Tensor(int r, int c, float fill = 0.0f)
       : rows(r), cols(c), data((size_t)r * (size_t)c, fill) {}
 
   Tensor(const Tensor &) = default;
-  Tensor &operator=(const Tensor &) = default;
+  // Assigning into a view (e.g. an arena-backed parameter) writes through
+  // it and requires the same element count; use rebind() to replace it.
+  Tensor &operator=(const Tensor &other);
 
   Tensor(Tensor &&other) noexcept;
-  Tensor &operator=(Tensor &&other) noexcept;
+  Tensor &operator=(Tensor &&other);
+
+  // Takes over other's shape and memory, owned or a view, replacing this
+  // tensor's storage even when it is a view. rebind(Tensor()) detaches.
+  void rebind(Tensor &&other) noexcept;
 
   inline float &operator()(int r, int c) {
     CHECK(r >= 0 && r < rows && c >= 0 && c < cols,
@@ -41,6 +48,27 @@ struct Tensor {
   static Tensor zeros(int r, int c) { return Tensor(r, c, 0.0f); }
   static Tensor ones(int r, int c) { return Tensor(r, c, 1.0f); }
 
+  // Non-owning r x c tensor over external memory. Copies of a view are
+  // owning; writes through the view land in the external buffer.
+  static Tensor view(float *ptr, int r, int c) {
+    Tensor t;
+    t.rows = r;
+    t.cols = c;
+    t.data = Storage::view(ptr, (size_t)r * (size_t)c);
+    return t;
+  }
+
+  bool is_view() const { return data.is_view(); }
+
+  // Reshape to r x c, reusing the current allocation when it is large
+  // enough. Contents are unspecified afterwards; callers overwrite them.
+  // A view can only be reshaped to the same element count.
+  void resize(int r, int c) {
+    data.resize((size_t)r * (size_t)c);
+    rows = r;
+    cols = c;
+  }
+
   void fill_(float v) {
     for (auto &x : data)
       x = v;
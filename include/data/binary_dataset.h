@@ -0,0 +1,121 @@
+#pragma once
+#include "core/dtype.h"
+#include "data/dataset.h"
+#include "io/mapped_file.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace tf {
+
+// On-disk dataset layout ("TNDS"), little-endian:
+//
+//   [0, 64)          BinaryDatasetHeader
+//   [x_offset, ...)  rows x x_cols features, row-major, x_dtype
+//   [y_offset, ...)  rows x y_cols targets, row-major, f32
+//
+// Both blocks start on a kBlockAlign boundary so they can be mapped and
+// madvise'd independently. u8 features decode as q * x_scale + x_bias.
+struct BinaryDatasetHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t rows;
+  uint32_t x_cols;
+  uint32_t y_cols;
+  uint32_t x_dtype;
+  uint32_t y_dtype;
+  uint64_t x_offset;
+  uint64_t y_offset;
+  float x_scale;
+  float x_bias;
+  uint32_t reserved[2];
+};
+static_assert(sizeof(BinaryDatasetHeader) == 64, "header must be 64 bytes");
+
+// Streams rows into a TNDS file without knowing the row count up front.
+// Features go straight to the output file; targets are staged in a side
+// file and appended by finish().
+class BinaryDatasetWriter {
+public:
+  static constexpr size_t kBlockAlign = 4096;
+
+  BinaryDatasetWriter(const std::string &path, int x_cols, int y_cols,
+                      DType x_dtype = DType::F32, float x_scale = 1.0f,
+                      float x_bias = 0.0f);
+  ~BinaryDatasetWriter();
+
+  BinaryDatasetWriter(const BinaryDatasetWriter &) = delete;
+  BinaryDatasetWriter &operator=(const BinaryDatasetWriter &) = delete;
+
+  // Appends n rows; x is n x x_cols and y is n x y_cols, both row-major.
+  void append(const float *x, const float *y, size_t n);
+  void append(const Tensor &x, const Tensor &y);
+
+  // Writes the targets block and the final header. Called by the
+  // destructor if needed, but only an explicit call reports errors.
+  void finish();
+
+  size_t rows() const { return rows_; }
+
+private:
+  std::string path_;
+  std::string y_path_;
+  std::ofstream out_;
+  std::ofstream y_out_;
+  BinaryDatasetHeader header_;
+  size_t rows_ = 0;
+  bool finished_ = false;
+  std::vector<uint8_t> encode_buf_;
+};
+
+void save_binary_dataset(const TensorDataset &ds, const std::string &path,
+                         DType x_dtype = DType::F32, float x_scale = 1.0f,
+                         float x_bias = 0.0f);
+
+// Dataset served straight from a memory-mapped TNDS file: nothing is
+// parsed or copied at open time, and pages are faulted in as rows are
+// read, so the file may be larger than RAM.
+//
+// With zero-copy enabled (off by default), get_batch on a run of
+// consecutive indices of an f32 file returns views into the mapping instead
+// of copying. The file is then mapped copy-on-write, so writes through a
+// view stay private and never reach the file. Views are only valid while
+// the dataset lives, and they replace the caller's batch tensors, so the
+// buffers get_batch would otherwise reuse are released.
+class MmapDataset : public Dataset {
+public:
+  explicit MmapDataset(const std::string &path,
+                       Access access = Access::Random);
+
+  size_t size() const override { return rows_; }
+  Sample get(size_t i) const override;
+  void get_batch(const size_t *idx, size_t n, Tensor &x,
+                 Tensor &y) const override;
+  void will_need(size_t begin, size_t n) const override;
+
+  int feature_cols() const { return x_cols_; }
+  int target_cols() const { return y_cols_; }
+  DType feature_dtype() const { return x_dtype_; }
+
+  // Re-hint the mapping, e.g. Sequential for an unshuffled pass.
+  void advise(Access access) const { file_.advise(access); }
+  // Enabling remaps the file copy-on-write; see the class comment.
+  void set_zero_copy(bool on);
+
+private:
+  void gather_x(const size_t *idx, size_t n, float *dst) const;
+
+  MappedFile file_;
+  size_t rows_ = 0;
+  int x_cols_ = 0;
+  int y_cols_ = 0;
+  DType x_dtype_ = DType::F32;
+  float x_scale_ = 1.0f;
+  float x_bias_ = 0.0f;
+  const uint8_t *x_base_ = nullptr;
+  const float *y_base_ = nullptr;
+  Access access_ = Access::Random;
+  bool zero_copy_ = false;
+};
+
+}  
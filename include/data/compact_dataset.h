@@ -0,0 +1,51 @@
+#pragma once
+#include "core/dtype.h"
+#include "data/dataset.h"
+#include <cstdint>
+#include <vector>
+
+namespace tf {
+
+// Dataset whose features are stored as compact codes (u8, i16 or f16)
+// instead of fp32. Feature j decodes as code * scale[j] + offset[j]; the
+// decode is fused into the row gather that builds the fp32 batch, so the
+// dataset takes 2-4x less memory and each epoch reads 2-4x fewer bytes.
+// Targets stay fp32 (they are usually small, e.g. one-hot labels).
+class CompactDataset : public Dataset {
+public:
+  // codes holds rows x cols values of dtype, row-major. Empty scale /
+  // offset mean 1 / 0 for every column; this is where a normalization
+  // such as (pixel / 255 - mean) / std goes.
+  CompactDataset(DType dtype, int rows, int cols, std::vector<uint8_t> codes,
+                 Tensor y, std::vector<float> scale = {},
+                 std::vector<float> offset = {});
+
+  // Quantize fp32 features. u8 / i16 map each column's [min, max] onto
+  // the full code range; f16 stores values directly.
+  static CompactDataset quantize(const Tensor &x, Tensor y, DType dtype);
+
+  size_t size() const override { return (size_t)rows_; }
+  Sample get(size_t i) const override;
+  void get_batch(const size_t *idx, size_t n, Tensor &x,
+                 Tensor &y) const override;
+
+  DType dtype() const { return dtype_; }
+  int feature_cols() const { return cols_; }
+  const std::vector<float> &scale() const { return scale_; }
+  const std::vector<float> &offset() const { return offset_; }
+  // Bytes held for features (codes plus per-column scale/offset).
+  size_t feature_bytes() const;
+
+private:
+  void decode_rows(const size_t *idx, size_t n, float *dst) const;
+
+  DType dtype_;
+  int rows_;
+  int cols_;
+  std::vector<uint8_t> codes_;
+  std::vector<float> scale_;
+  std::vector<float> offset_;
+  Tensor y_;
+};
+
+}  
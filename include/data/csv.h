@@ -0,0 +1,53 @@
+#pragma once
+#include "core/dtype.h"
+#include "data/dataset.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tf {
+
+// Numeric CSV ingestion. Quoted fields are not supported; every selected
+// field must be a number.
+struct CsvOptions {
+  char delimiter = ',';
+  bool has_header = true;
+
+  // Label column, by index (-1 = last column) or by header name (takes
+  // precedence when non-empty).
+  int label_column = -1;
+  std::string label_name;
+
+  // Feature columns, by index or by header name. Both empty selects every
+  // column except the label.
+  std::vector<int> feature_columns;
+  std::vector<std::string> feature_names;
+
+  // > 0: the label is an integer class id in [0, num_classes), encoded
+  // one-hot. 0: the label is copied as a single float target.
+  int num_classes = 0;
+
+  // The file is read and parsed chunk_bytes at a time, so memory stays
+  // bounded when writing to disk. Each chunk is split across num_threads
+  // parsers (0 = hardware concurrency).
+  size_t chunk_bytes = 16u << 20;
+  size_t num_threads = 0;
+};
+
+// Parse a float from [begin, end). Returns the position after the number,
+// or nullptr when the text does not start with one. Results are within
+// one ulp of strtof.
+const char *parse_float(const char *begin, const char *end, float &out);
+
+TensorDataset read_csv(const std::string &path,
+                       const CsvOptions &opts = CsvOptions());
+
+// Streams a CSV file into the binary dataset format (see
+// data/binary_dataset.h) with memory bounded by opts.chunk_bytes. Returns
+// the number of rows written.
+size_t csv_to_binary(const std::string &csv_path, const std::string &out_path,
+                     const CsvOptions &opts = CsvOptions(),
+                     DType x_dtype = DType::F32, float x_scale = 1.0f,
+                     float x_bias = 0.0f);
+
+}  
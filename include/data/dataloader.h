@@ -1,27 +1,101 @@
 #pragma once
 #include "core/rng.h"
 #include "data/dataset.h"
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <mutex>
 #include <numeric>
+#include <string>
+#include <thread>
 #include <vector>
 
 namespace tf {
 
+class TrainingState;
+
+struct LoaderOptions {
+  bool shuffle = true;
+  uint64_t seed = 42;
+  // Number of batches assembled ahead of the consumer on background
+  // threads. 0 (with num_workers <= 1) assembles each batch synchronously
+  // inside next().
+  size_t prefetch = 0;
+  // Threads assembling whole batches concurrently. Batches are still handed
+  // out in shuffle order; the ring doubles as the reorder buffer, so it is
+  // sized to at least num_workers slots.
+  size_t num_workers = 1;
+  // Block shuffle for disk-backed data. When shuffle_block > 0 the rows are
+  // cut into contiguous blocks of that many rows; the block order is
+  // shuffled, then rows are shuffled within windows of shuffle_window
+  // consecutive blocks (in the shuffled order). Each window touches only
+  // shuffle_window blocks, so reads stay local; larger windows (or blocks)
+  // trade locality for randomness. 0 keeps the global row shuffle.
+  size_t shuffle_block = 0;
+  size_t shuffle_window = 8;
+};
+
+struct LoaderStats {
+  size_t batches = 0;       // batches handed out by next()
+  size_t stalls = 0;        // next() calls that had to wait for data
+  double stall_seconds = 0; // total time spent waiting
+};
+
 class DataLoader {
 public:
   DataLoader(Dataset &dataset, size_t batch_size, bool shuffle,
              uint64_t seed = 42);
+  DataLoader(Dataset &dataset, size_t batch_size, const LoaderOptions &opts);
+  ~DataLoader();
+
+  DataLoader(const DataLoader &) = delete;
+  DataLoader &operator=(const DataLoader &) = delete;
 
+  // Starts a new epoch. With prefetching, batches of the new epoch begin
+  // assembling immediately, in the same order a synchronous loader would
+  // produce them.
   void reset();
 
-  
-  
+  // Writes the next batch into batch_x / batch_y, reusing their storage
+  // when it is large enough. Returns false once the epoch is exhausted.
+  // In prefetch mode the tensors are swapped with a ring buffer, so the
+  // caller's old buffers are recycled for later batches.
   bool next(Tensor &batch_x, Tensor &batch_y);
 
   size_t len() const;  
   size_t size() const; 
 
+  // Shuffle RNG, current permutation and position within the epoch. Import
+  // into a loader over the same dataset with the same batch size and
+  // options; the dataset size, batch size and shuffle / block-shuffle
+  // options are stored and CHECKed. The seed and prefetch settings may
+  // differ. Prefetched batches are discarded and reassembled from the
+  // restored position.
+  void export_state(TrainingState &out,
+                    const std::string &prefix = "loader/") const;
+  void import_state(const TrainingState &in,
+                    const std::string &prefix = "loader/");
+
+  const LoaderStats &stats() const { return stats_; }
+  void reset_stats() { stats_ = LoaderStats(); }
+
 private:
+  struct Slot {
+    Tensor x;
+    Tensor y;
+    size_t batch = 0;
+    bool ready = false;
+    std::exception_ptr error;
+  };
+
+  void shuffle_indices();
+  void block_shuffle_indices();
+  void hint_windows(size_t begin, size_t end) const;
+  void fill(size_t batch, Tensor &x, Tensor &y) const;
+  void start_workers(size_t n);
+  void stop_workers();
+  void worker_loop();
+
   Dataset &dataset_;
   size_t batch_size_;
   bool shuffle_;
@@ -29,6 +103,30 @@ private:
 
   std::vector<size_t> indices_;
   size_t current_idx_;
+
+  // Block shuffle: shuffled block ids and the position in indices_ where
+  // each window starts (plus a final end sentinel).
+  size_t shuffle_block_ = 0;
+  size_t shuffle_window_ = 0;
+  std::vector<size_t> block_order_;
+  std::vector<size_t> window_begin_;
+
+  // Prefetch ring and reorder buffer. Batch b lives in
+  // slots_[b % slots_.size()]; a worker may claim batch b only once batch
+  // b - slots_.size() has been consumed, so workers finishing out of order
+  // never overwrite each other.
+  std::vector<Slot> slots_;
+  std::vector<std::thread> workers_;
+  std::mutex mu_;
+  std::condition_variable work_cv_;
+  std::condition_variable ready_cv_;
+  size_t num_batches_ = 0;
+  size_t next_claim_ = 0;
+  size_t consumed_ = 0;
+  size_t in_flight_ = 0;
+  bool stop_ = false;
+
+  LoaderStats stats_;
 };
 
 }  
@@ -15,6 +15,21 @@ public:
   virtual ~Dataset() = default;
   virtual size_t size() const = 0;
   virtual Sample get(size_t i) const = 0;
+
+  // Gather rows idx[0..n) into x (n x features) and y (n x targets),
+  // reusing their allocations when large enough. The default goes through
+  // get(); datasets backed by contiguous memory should override it.
+  // Loader workers may call get() and get_batch() concurrently.
+  virtual void get_batch(const size_t *idx, size_t n, Tensor &x,
+                         Tensor &y) const;
+
+  // Hint that rows [begin, begin + n) will be read soon. Disk-backed
+  // datasets can start fetching them; the default does nothing. Loader
+  // workers may call it concurrently, so overrides must be thread-safe.
+  virtual void will_need(size_t begin, size_t n) const {
+    (void)begin;
+    (void)n;
+  }
 };
 
 
@@ -27,7 +42,7 @@ public:
   size_t size() const override { return x_.rows; }
 
   Sample get(size_t i) const override {
-    CHECK(i < x_.rows, "Index out of bounds");
+    CHECK(i < (size_t)x_.rows, "Index out of bounds");
 
     
     Tensor row_x(1, x_.cols);
@@ -44,6 +59,9 @@ public:
     return {std::move(row_x), std::move(row_y)};
   }
 
+  void get_batch(const size_t *idx, size_t n, Tensor &x,
+                 Tensor &y) const override;
+
   
   const Tensor &features() const { return x_; }
   const Tensor &targets() const { return y_; }
@@ -0,0 +1,120 @@
+#pragma once
+#include "core/rng.h"
+#include "core/tensor.h"
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace tf {
+
+// A source of samples with no known size and no random access: a pipe, a
+// socket, a log being tailed, a generator. Rows are pulled in chunks.
+class IterableDataset {
+public:
+  virtual ~IterableDataset() = default;
+  virtual int feature_cols() const = 0;
+  virtual int target_cols() const = 0;
+
+  // Writes up to max_rows rows into x (max_rows x feature_cols) and y
+  // (max_rows x target_cols), row-major. Returns the number written; 0
+  // means the stream has ended. May block waiting for data.
+  virtual size_t read(float *x, float *y, size_t max_rows) = 0;
+};
+
+// Wraps a callback that fills one sample and returns false at the end.
+class GeneratorDataset : public IterableDataset {
+public:
+  using Fn = std::function<bool(float *x, float *y)>;
+
+  GeneratorDataset(int x_cols, int y_cols, Fn fn)
+      : x_cols_(x_cols), y_cols_(y_cols), fn_(std::move(fn)) {}
+
+  int feature_cols() const override { return x_cols_; }
+  int target_cols() const override { return y_cols_; }
+  size_t read(float *x, float *y, size_t max_rows) override;
+
+private:
+  int x_cols_;
+  int y_cols_;
+  Fn fn_;
+  bool done_ = false;
+};
+
+// Delimited text records from a stream (std::cin, an opened FIFO, a
+// socket wrapped in a streambuf): `features` numbers followed by a label.
+// With num_classes > 0 the label is a class id encoded one-hot, otherwise
+// a single float target. Blank lines are skipped.
+class TextStreamDataset : public IterableDataset {
+public:
+  TextStreamDataset(std::istream &in, int features, int num_classes = 0,
+                    char delimiter = ',');
+
+  int feature_cols() const override { return features_; }
+  int target_cols() const override {
+    return num_classes_ > 0 ? num_classes_ : 1;
+  }
+  size_t read(float *x, float *y, size_t max_rows) override;
+
+  size_t lines_read() const { return lines_; }
+
+private:
+  std::istream &in_;
+  int features_;
+  int num_classes_;
+  char delimiter_;
+  std::string line_;
+  size_t lines_ = 0;
+};
+
+struct StreamOptions {
+  // Rows held for shuffling. Each emitted row is drawn uniformly from the
+  // buffer and replaced by the next incoming row, so a row is emitted at
+  // most this many positions early; it can stay buffered, and so be
+  // emitted, arbitrarily late. 1 keeps stream order.
+  size_t shuffle_buffer = 1024;
+  // Rows pulled from the source per read().
+  size_t chunk_rows = 256;
+  uint64_t seed = 42;
+};
+
+// Batches an IterableDataset with bounded memory: the shuffle buffer, one
+// pending chunk and the caller's batch.
+class StreamLoader {
+public:
+  StreamLoader(IterableDataset &source, size_t batch_size,
+               const StreamOptions &opts = StreamOptions());
+
+  // Writes the next batch (reusing the tensors' storage). The last batch
+  // may be short; returns false once the source is exhausted and the
+  // buffer drained.
+  bool next(Tensor &batch_x, Tensor &batch_y);
+
+  size_t rows_emitted() const { return emitted_; }
+
+private:
+  bool pull_row(size_t slot);
+  void refill_chunk();
+
+  IterableDataset &src_;
+  size_t batch_size_;
+  size_t capacity_;
+  size_t chunk_rows_;
+  int xc_;
+  int yc_;
+  RNG rng_;
+
+  std::vector<float> buf_x_;
+  std::vector<float> buf_y_;
+  size_t count_ = 0; // rows in the shuffle buffer
+
+  std::vector<float> chunk_x_;
+  std::vector<float> chunk_y_;
+  size_t chunk_len_ = 0;
+  size_t chunk_pos_ = 0;
+  bool eof_ = false;
+  size_t emitted_ = 0;
+};
+
+}  
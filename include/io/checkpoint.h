@@ -1,11 +1,162 @@
 #pragma once
+#include "core/dtype.h"
+#include "io/mapped_file.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace tf {
 
 class Module;
 
-void save_checkpoint(const Module &model, const std::string &path);
+enum class CheckpointFormat {
+  V1, // "TNN1": tensors back to back, read sequentially
+  V2, // "TNN2": indexed, 64-byte aligned, CRC32C per tensor, mmap-able
+};
+
+// Writes V2 unless asked otherwise. V2 files are written to `path.tmp`,
+// fsynced and renamed over `path`, so a crash never leaves a torn file.
+void save_checkpoint(const Module &model, const std::string &path,
+                     CheckpointFormat format = CheckpointFormat::V2);
+// Storage dtypes for a V2 save, chosen separately for matrices (weights)
+// and vectors (NamedParam::bias). F16 and BF16 store the rounded values; I8
+// stores symmetric codes with one f32 scale per column (per output unit of
+// a Dense weight) in an extra "<name>#scale" entry, and refuses non-finite
+// values. Every dtype is decoded back into fp32 parameters on load.
+struct CheckpointStorage {
+  DType matrices = DType::F32;
+  DType vectors = DType::F32;
+};
+void save_checkpoint(const Module &model, const std::string &path,
+                     const CheckpointStorage &storage);
+
+// Reads either format (detected from the magic), following delta chains
+// (io/delta_checkpoint.h).
 void load_checkpoint(Module &model, const std::string &path);
 
+// One named tensor for save_checkpoint_entries(); `data` holds
+// rows * cols elements of `dtype`.
+struct CheckpointSource {
+  std::string name;
+  DType dtype = DType::F32;
+  int rows = 0;
+  int cols = 0;
+  const void *data = nullptr;
+};
+
+// Writes arbitrary named tensors as a V2 file (atomically, like
+// save_checkpoint).
+void save_checkpoint_entries(const std::vector<CheckpointSource> &sources,
+                             const std::string &path);
+
+// V2 layout, little-endian:
+//
+//   [0, 64)            header: magic, version, tensor count, index
+//                      offset/size, index CRC, file size
+//   [64, ...)          index: per tensor name, dtype, shape, payload
+//                      offset, payload bytes, payload CRC32C
+//   [data_offset, ...) payloads, each starting on a 64-byte boundary
+struct CheckpointEntry {
+  std::string name;
+  DType dtype = DType::F32;
+  int rows = 0;
+  int cols = 0;
+  uint64_t offset = 0;
+  uint64_t nbytes = 0;
+  uint32_t crc = 0;
+};
+
+// Memory-mapped V2 checkpoint. Opening parses only the index; payloads
+// are paged in on first touch.
+class CheckpointReader {
+public:
+  static constexpr size_t kAlign = 64;
+
+  // With verify, every payload CRC is checked (in parallel) before use.
+  explicit CheckpointReader(const std::string &path, bool verify = true);
+
+  const std::string &path() const { return file_.path(); }
+  const std::vector<CheckpointEntry> &entries() const { return entries_; }
+  const CheckpointEntry *find(const std::string &name) const;
+  const void *payload(const CheckpointEntry &e) const {
+    return file_.data() + e.offset;
+  }
+  // Writable (copy-on-write) view of a payload, for zero-copy tensors.
+  void *mutable_payload(const CheckpointEntry &e) {
+    return file_.mutable_data() + e.offset;
+  }
+
+  // Decodes an F32, F16, BF16 or I8 entry into rows * cols floats.
+  void read_f32(const CheckpointEntry &e, float *dst) const;
+
+  // Parallel copy (or decode, for compact dtypes) into the model's
+  // parameters. Names and shapes must match; entries whose name contains
+  // '#' are auxiliary (scales, delta metadata) and are skipped.
+  void load_into(Module &model) const;
+
+  // Zero-copy (F32 entries only): repoints the model's parameters at the
+  // mapping. The mapping is copy-on-write, so training still works
+  // (touched pages become private) and the file is never modified. The
+  // reader must outlive the model's use of those parameters.
+  void bind(Module &model);
+
+private:
+  void verify_payloads() const;
+  const float *scales(const CheckpointEntry &e) const;
+  void decode(const CheckpointEntry &e, const float *scale, size_t begin,
+              size_t end, float *dst) const;
+
+  MappedFile file_;
+  std::vector<CheckpointEntry> entries_;
+  std::unordered_map<std::string, size_t> by_name_;
+};
+
+struct StagedCheckpoint;
+
+// Writes V2 checkpoints off the training thread. save() only copies the
+// parameters into a staging buffer laid out like the file; checksumming,
+// writing, fsync and the rename happen on one background thread that takes
+// jobs in FIFO order, so writes complete in submission order. Two staging
+// buffers are kept, so a save returns immediately while at most one
+// earlier write is still in flight.
+class AsyncCheckpointWriter {
+public:
+  AsyncCheckpointWriter();
+  ~AsyncCheckpointWriter(); // waits for pending writes
+  AsyncCheckpointWriter(const AsyncCheckpointWriter &) = delete;
+  AsyncCheckpointWriter &operator=(const AsyncCheckpointWriter &) = delete;
+
+  // The model may be modified as soon as this returns. get() on the
+  // result rethrows any write error.
+  std::shared_future<void> save(const Module &model, const std::string &path);
+
+  // Blocks until every submitted write has finished.
+  void wait();
+
+private:
+  struct Job {
+    StagedCheckpoint *staged;
+    std::string path;
+    std::promise<void> done;
+  };
+  void run();
+
+  std::unique_ptr<StagedCheckpoint> staged_[2];
+  std::shared_future<void> done_[2];
+  int next_ = 0;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<Job> jobs_;
+  bool stop_ = false;
+  std::thread worker_;
+};
+
 }  
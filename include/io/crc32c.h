@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace tf {
+
+// CRC-32C (Castagnoli). Uses the SSE4.2 crc32 instruction when the build
+// targets it, a slicing-by-8 table otherwise. Pass the previous result as
+// crc to checksum data in pieces.
+uint32_t crc32c(const void *data, size_t n, uint32_t crc = 0);
+
+}  
@@ -0,0 +1,74 @@
+#pragma once
+#include "io/checkpoint.h"
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tf {
+
+class Module;
+
+// Delta checkpoints: a chain of V2 files starting at a full snapshot, where
+// every later file stores only the fixed-size blocks of each tensor that
+// changed since the previous file. For a parameter `p` a delta holds
+//
+//   "p#blocks"  u8   the changed block ids (uint32)
+//   "p#data"    f32  one row of block_elems values per changed block (the
+//                    tail block is zero-padded)
+//
+// plus "#delta" (format version, block size, position in the chain) and
+// "#parent" (path of the previous file, relative to the delta's directory
+// when both share one). Tensors with no changed block are omitted.
+// load_checkpoint() follows the chain back to its base transparently.
+
+struct DeltaStats {
+  bool full = false;         // a full snapshot was written
+  size_t tensors_changed = 0;
+  size_t blocks_changed = 0;
+  size_t blocks_total = 0;
+  size_t bytes_written = 0;  // file size
+};
+
+// Produces a chain of snapshots of one model. Keeps a shadow copy of the
+// last saved parameters (one extra copy of the model in memory) and
+// compares against it, so a save reads the model once and writes only the
+// blocks that differ bitwise.
+class DeltaCheckpointWriter {
+public:
+  // Every max_chain-th save is a full snapshot (0: only the first one).
+  explicit DeltaCheckpointWriter(size_t block_elems = 1024,
+                                 size_t max_chain = 0);
+
+  // Saves a full snapshot the first time and after reset(); afterwards a
+  // delta whose parent is the previously saved path. Earlier files of the
+  // chain must stay in place until compacted. Saving to a path already in
+  // the current chain (e.g. always "latest.tnn") writes a full snapshot.
+  // If the write throws, the blocks it held are written by the next save.
+  DeltaStats save(const Module &model, const std::string &path);
+
+  // Makes the next save a full snapshot.
+  void reset();
+
+private:
+  size_t block_elems_;
+  size_t max_chain_;
+  size_t seq_ = 0;
+  std::vector<std::string> chain_; // paths written since the last full save
+  std::unordered_map<std::string, std::vector<float>> shadow_;
+};
+
+// True if the file is a delta (as opposed to a full V2 snapshot).
+bool is_delta_checkpoint(const CheckpointReader &reader);
+
+// Files of the chain ending at `path`, base first.
+std::vector<std::string> checkpoint_chain(const std::string &path);
+
+// Loads the chain ending at `path` into the model (used by
+// load_checkpoint() for delta files).
+void load_delta_checkpoint(Module &model, const std::string &path);
+
+// Folds the chain ending at `path` into a single full V2 checkpoint.
+void compact_checkpoint(const std::string &path, const std::string &out);
+
+}  
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tf {
+
+// Expected access pattern, forwarded to the kernel as madvise hints.
+enum class Access {
+  Normal,
+  Sequential, // aggressive read-ahead, pages dropped behind the reader
+  Random,     // no read-ahead
+};
+
+// Memory mapping of a whole file. The mapping lives as long as the object;
+// pointers into it must not outlive it. By default it is read-only; a
+// copy-on-write mapping may be written through, with modified pages
+// becoming private copies and the file left untouched. It reserves no swap
+// up front (MAP_NORESERVE), so files larger than memory can be mapped; only
+// writing more pages than memory can hold fails, at the write. On
+// platforms without mmap the file is read into memory instead.
+class MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &path, bool copy_on_write = false);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  const uint8_t *data() const { return data_; }
+  // Writable pointer; only valid for copy-on-write mappings.
+  uint8_t *mutable_data() const;
+  size_t size() const { return size_; }
+  bool is_open() const { return data_ != nullptr; }
+  const std::string &path() const { return path_; }
+
+  // Hint for the byte range [offset, offset + len); len == 0 means "to the
+  // end". Hints are best effort and never fail.
+  void advise(Access access, size_t offset = 0, size_t len = 0) const;
+  // Start reading [offset, offset + len) into the page cache.
+  void prefetch(size_t offset, size_t len) const;
+
+private:
+  void close();
+
+  std::string path_;
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  bool writable_ = false;
+  std::vector<uint8_t> fallback_;
+};
+
+}  
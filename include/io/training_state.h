@@ -0,0 +1,81 @@
+#pragma once
+#include "core/dtype.h"
+#include "core/error.h"
+#include "core/tensor.h"
+#include "io/checkpoint.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tf {
+
+class Module;
+class Adam;
+class DataLoader;
+
+// Everything needed to resume training exactly: named tensors and raw
+// blobs contributed by the model, optimizer and loader, stored as a V2
+// checkpoint (indexed, CRC-checked, memory-mapped on load).
+//
+// Writing: put*() record entries and save() writes them. put() and
+// put_bytes() reference the caller's memory until save(); put_value()
+// copies. Reading: the path constructor maps the file, and get*() copy
+// entries out.
+class TrainingState {
+public:
+  TrainingState() = default;
+  explicit TrainingState(const std::string &path);
+
+  void put(const std::string &name, const float *data, int rows, int cols);
+  void put(const std::string &name, const Tensor &t) {
+    put(name, t.data.data(), t.rows, t.cols);
+  }
+  void put_bytes(const std::string &name, const void *data, size_t bytes);
+  template <typename T> void put_value(const std::string &name, const T &v) {
+    owned_.emplace_back(reinterpret_cast<const uint8_t *>(&v),
+                        reinterpret_cast<const uint8_t *>(&v) + sizeof(T));
+    put_bytes(name, owned_.back().data(), sizeof(T));
+  }
+
+  void save(const std::string &path) const;
+
+  bool contains(const std::string &name) const;
+  // Copies a float entry into dst, which must have the stored shape.
+  void get(const std::string &name, float *dst, int rows, int cols) const;
+  void get(const std::string &name, Tensor &dst) const {
+    get(name, dst.data.data(), dst.rows, dst.cols);
+  }
+  // Size of a raw entry, and a copy of it into dst (exactly bytes long).
+  size_t bytes(const std::string &name) const;
+  void get_bytes(const std::string &name, void *dst, size_t bytes) const;
+  template <typename T> T value(const std::string &name) const {
+    T v;
+    get_bytes(name, &v, sizeof(T));
+    return v;
+  }
+
+private:
+  const CheckpointEntry &entry(const std::string &name) const;
+
+  std::vector<CheckpointSource> sources_;
+  std::deque<std::vector<uint8_t>> owned_;
+
+  std::unique_ptr<CheckpointReader> reader_;
+  std::unordered_map<std::string, const CheckpointEntry *> by_name_;
+};
+
+// Model parameters, Adam moments and timestep, loader RNG/permutation/
+// position and the epoch counter in one file. Resuming with the same
+// model topology, optimizer hyperparameters and loader options continues
+// bit-exactly where the saved run left off.
+void save_training_state(const std::string &path, const Module &model,
+                         const Adam &optim, const DataLoader &loader,
+                         int epoch);
+// Restores everything save_training_state() wrote; returns the epoch.
+int load_training_state(const std::string &path, Module &model, Adam &optim,
+                        DataLoader &loader);
+
+}  
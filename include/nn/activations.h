@@ -1,24 +1,38 @@
 #pragma once
 #include "nn/module.h"
+#include <cstdint>
+#include <vector>
 
 namespace tf {
 
+// In BF16 mode the activation cached for backward is kept at half width.
+
 class ReLU final : public Module {
 public:
   Tensor forward(const Tensor& x) override;
   Tensor backward(const Tensor& grad_out) override;
+  Module* clone() const override;
+  void set_precision(Precision p) override;
 
 private:
   Tensor x_cache;
+  Precision precision_ = Precision::FP32;
+  std::vector<uint16_t> x_cache_bf16;
 };
 
 class Sigmoid final : public Module {
 public:
   Tensor forward(const Tensor& x) override;
   Tensor backward(const Tensor& grad_out) override;
+  Module* clone() const override;
+  void set_precision(Precision p) override;
 
 private:
   Tensor y_cache;
+  Precision precision_ = Precision::FP32;
+  std::vector<uint16_t> y_cache_bf16;
+  int rows_ = 0;
+  int cols_ = 0;
 };
 
 }
@@ -0,0 +1,58 @@
+#pragma once
+#include "nn/param_arena.h"
+#include "nn/sequential.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace tf {
+
+// Synchronous data-parallel training on a single machine.
+//
+// The model is replicated once per worker thread. Each call to
+// forward_backward() splits the batch row-wise across the replicas, runs
+// forward/backward on all of them concurrently and tree-reduces the replica
+// gradients into the model's own gradient tensors. The optimizer then steps
+// model.params() exactly as in single-threaded training.
+class DataParallel {
+public:
+  using LossFn =
+      std::function<float(const Tensor &, const Tensor &, Tensor &)>;
+
+  DataParallel(Sequential &model, int num_replicas);
+
+  // Returns the mean loss over the whole batch. Gradients are accumulated
+  // into the model's grads (same semantics as Module::backward).
+  float forward_backward(const Tensor &x, const Tensor &y,
+                         const LossFn &loss_fn);
+
+  int num_replicas() const { return (int)replicas_.size(); }
+
+private:
+  void broadcast();
+  void allreduce(int active);
+
+  // A slice of one parameter's gradient: [begin, end) within the tensor,
+  // located at arena_offset + begin in every replica's arena.
+  struct Block {
+    size_t param;
+    size_t begin;
+    size_t end;
+    size_t arena_offset;
+  };
+
+  std::vector<Param> params_;
+
+  // Replica gradients live in one flat arena per replica, so zeroing and
+  // reduction are streaming passes over contiguous memory.
+  std::vector<std::unique_ptr<Module>> replicas_;
+  std::vector<std::unique_ptr<ParamArena>> arenas_;
+
+  std::vector<Tensor> shard_x_;
+  std::vector<Tensor> shard_y_;
+  std::vector<float> shard_loss_;
+
+  std::vector<Block> blocks_;
+};
+
+}  
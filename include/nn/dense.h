@@ -1,6 +1,9 @@
 #pragma once
+#include "core/math.h"
 #include "core/rng.h"
 #include "nn/module.h"
+#include <cstdint>
+#include <vector>
 
 namespace tf {
 
@@ -10,9 +13,18 @@ public:
 
   Tensor forward(const Tensor &x) override;
   Tensor backward(const Tensor &grad_out) override;
+  // act(forward(x)) in one pass over the output, for inference mode
+  // (Sequential uses it for Dense followed by ReLU or Sigmoid).
+  Tensor forward_fused(const Tensor &x, Activation act);
   std::vector<NamedParam> named_parameters() const override;
+  Module *clone() const override;
+  void set_precision(Precision p) override;
+  void set_training(bool training) override;
+  void parameters_changed() override;
 
 private:
+  Tensor affine(const Tensor &x, Activation act);
+
   Tensor W;
   Tensor b;
 
@@ -20,6 +32,25 @@ private:
   Tensor db;
 
   Tensor x_cache;
+
+  // W in the GEMM panel layout. In training mode it is refreshed in place
+  // by every forward that uses it (W changes between steps); in inference
+  // mode it is packed once and reused until parameters_changed() or a mode
+  // switch.
+  bool training_ = true;
+  PackedMatrix W_packed;
+  bool packed_valid_ = false;
+
+  // BF16 mode keeps the cached input at half width instead of x_cache and
+  // runs the packed kernel on bfloat16 panels of W (W^T and grad_out panels
+  // in backward). Scratch buffers are reused across steps.
+  Precision precision_ = Precision::FP32;
+  std::vector<uint16_t> x_cache_bf16;
+  PackedMatrixBF16 W_packed_bf16;
+  PackedMatrixBF16 scratch_packed_bf16;
+  std::vector<uint16_t> scratch_bf16;
+  int x_rows = 0;
+  int x_cols = 0;
 };
 
 }  
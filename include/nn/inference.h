@@ -0,0 +1,50 @@
+#pragma once
+#include "core/math.h"
+#include "core/tensor.h"
+#include "io/checkpoint.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tf {
+
+class Sequential;
+
+// Inference bundle: a V2 checkpoint holding the layer graph ("#graph":
+// Dense / ReLU / Sigmoid with their shapes) and, for every Dense layer i,
+// W already in the GEMM panel layout ("i.W#packed", see PackedMatrix) and
+// the bias ("i.b"). Only Sequential models of those layers can be exported.
+void export_inference(const Sequential &model, const std::string &path);
+
+// Forward-only model loaded from an inference bundle. The file is mapped
+// and every layer points straight into the mapping: no model code, no
+// weight copy and no repacking, so startup costs one index parse (plus a
+// CRC pass over the payloads with verify) and pages fault in on first use.
+class InferenceModel {
+public:
+  explicit InferenceModel(const std::string &path, bool verify = true);
+
+  InferenceModel(const InferenceModel &) = delete;
+  InferenceModel &operator=(const InferenceModel &) = delete;
+
+  Tensor forward(const Tensor &x) const;
+
+  int in_features() const;
+  int out_features() const;
+  size_t num_layers() const { return layers_.size(); }
+
+private:
+  enum class Op : uint32_t { Dense = 0, ReLU = 1, Sigmoid = 2 };
+  struct Layer {
+    Op op;
+    int in;
+    int out;
+    PackedMatrix W; // views into the mapping (Dense only)
+    Tensor b;
+  };
+
+  CheckpointReader reader_;
+  std::vector<Layer> layers_;
+};
+
+}  
@@ -4,6 +4,10 @@
 
 namespace tf {
 
+// Compute precision of a module. Parameters are always stored in fp32; in
+// BF16 mode GEMM operands and cached activations are kept in bfloat16.
+enum class Precision { FP32, BF16 };
+
 struct Param {
   Tensor *value;
   Tensor *grad;
@@ -13,6 +17,9 @@ struct NamedParam {
   std::string name;
   Tensor *value;
   Tensor *grad;
+  // Bias vector rather than a weight; a weight may also be a single row
+  // (Dense(1, N)), so the shape alone does not tell them apart.
+  bool bias = false;
 };
 
 class Module {
@@ -30,6 +37,24 @@ public:
     }
     return ps;
   }
+
+  virtual void set_precision(Precision) {}
+
+  // Training (default) or inference mode. Out of training, modules may keep
+  // caches derived from their parameters (Dense keeps W packed for the
+  // GEMM kernel) and skip state only backward needs. Optimizer steps should
+  // only happen in training mode.
+  virtual void set_training(bool) {}
+
+  // Called after parameters were overwritten from outside (checkpoint
+  // loads, zero-copy binds) so caches derived from them are dropped.
+  virtual void parameters_changed() {}
+
+  // Deep copy with independent parameters, gradients and caches. Used to
+  // build per-thread replicas; the caller owns the returned module.
+  virtual Module *clone() const {
+    THROW_ERROR("clone() is not implemented for this module");
+  }
 };
 
-}  
\ No newline at end of file
+}  
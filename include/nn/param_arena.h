@@ -0,0 +1,51 @@
+#pragma once
+#include "nn/module.h"
+#include <vector>
+
+namespace tf {
+
+// Packs all parameters of a model into one contiguous aligned buffer and all
+// gradients into a second one, then rebinds every parameter/gradient Tensor
+// of the model as a view into them. Existing values are preserved.
+//
+// Each tensor starts on a 64-byte boundary; the padding between tensors is
+// kept at zero, so the whole arena can be treated as a single flat tensor:
+// zero_grad() is one memset, grad_norm() one reduction, and an optimizer
+// stepping flat_params() makes one streaming pass instead of one per tensor.
+//
+// The arena must not outlive the model. On destruction the model's tensors
+// get owning copies of their current values back.
+class ParamArena {
+public:
+  explicit ParamArena(Module &model);
+  ~ParamArena();
+
+  ParamArena(const ParamArena &) = delete;
+  ParamArena &operator=(const ParamArena &) = delete;
+
+  // Per-tensor params (views into the arena), built once.
+  const std::vector<Param> &params() const { return params_; }
+
+  // A single Param covering the whole arena as a 1 x size() tensor.
+  std::vector<Param> flat_params() { return {Param{&values_, &grads_}}; }
+
+  size_t size() const { return values_.size(); }
+  float *values() { return values_.data.data(); }
+  float *grads() { return grads_.data.data(); }
+  const float *values() const { return values_.data.data(); }
+  const float *grads() const { return grads_.data.data(); }
+
+  // Offset of params()[i] inside the arena.
+  size_t offset(size_t i) const { return offsets_[i]; }
+
+  void zero_grad();
+  float grad_norm() const;
+
+private:
+  std::vector<Param> params_;
+  std::vector<size_t> offsets_;
+  Tensor values_;
+  Tensor grads_;
+};
+
+}  
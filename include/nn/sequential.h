@@ -1,5 +1,6 @@
 #pragma once
 #include "nn/module.h"
+#include <functional>
 #include <vector>
 
 namespace tf {
@@ -9,17 +10,59 @@ public:
   Sequential() = default;
   ~Sequential() override;
 
+  // Takes ownership; the module is switched to the model's training mode.
   void add(Module *m);
+  const std::vector<Module *> &modules() const { return modules_; }
 
   Tensor forward(const Tensor &x) override;
   Tensor backward(const Tensor &grad_out) override;
+
+  // Backward that calls on_grads_ready(params) for each module right after
+  // its backward, i.e. as soon as that module's gradients are final.
+  using GradsReadyFn = std::function<void(const std::vector<Param> &)>;
+  Tensor backward(const Tensor &grad_out, const GradsReadyFn &on_grads_ready);
+
+  // Optimizer-in-backward: every module's parameters are stepped while its
+  // gradients are still hot in cache, and the gradients are cleared in the
+  // same pass, so no separate zero_grad() or whole-model step() is needed.
+  // With drop_grads the gradient tensors are also released after the update
+  // (they are re-created by the next backward), so only one module's
+  // gradients are alive at a time. Between steps they are then 0x0, so
+  // nothing that reads whole-model gradients (LossScaler, gradient
+  // clipping, DataParallel allreduce) can be combined with it; LossScaler
+  // CHECKs for this. Gradients that are views into a ParamArena are only
+  // zeroed, never released, so drop_grads saves nothing there.
+  //
+  // Each module's parameter list is passed to optim.update() separately;
+  // ParamSlots caches one binding per list, so this stays pointer compares.
+  template <class Optim>
+  Tensor backward_step(const Tensor &grad_out, Optim &optim,
+                       bool drop_grads = false) {
+    optim.begin_step();
+    return backward(grad_out, [&](const std::vector<Param> &ps) {
+      optim.update(ps, /*zero_grad=*/true);
+      if (drop_grads)
+        release_grads(ps);
+    });
+  }
+
   std::vector<NamedParam> named_parameters() const override;
+  Module *clone() const override;
+  void set_precision(Precision p) override;
+  // Out of training, forward fuses each Dense with a following ReLU or
+  // Sigmoid into one kernel epilogue.
+  void set_training(bool training) override;
+  void parameters_changed() override;
 
   void save(const std::string &path);
   void load(const std::string &path);
 
 private:
+  static void release_grads(const std::vector<Param> &ps);
+
   std::vector<Module *> modules_;
+  std::vector<std::vector<Param>> module_params_;
+  bool training_ = true;
 };
 
 }  
@@ -1,32 +1,59 @@
 #pragma once
+#include "core/storage.h"
 #include "core/tensor.h"
 #include "nn/module.h"
-#include <unordered_map>
+#include "optim/param_slots.h"
+#include <string>
 #include <vector>
 
 namespace tf {
 
+class TrainingState;
+
 class Adam {
 public:
-  
+  // weight_decay > 0 enables decoupled weight decay (AdamW), applied in the
+  // same pass as the moment update.
   explicit Adam(float lr = 0.001f, float beta1 = 0.9f, float beta2 = 0.999f,
-                float eps = 1e-8f)
-      : lr_(lr), beta1_(beta1), beta2_(beta2), eps_(eps), t_(0) {}
+                float eps = 1e-8f, float weight_decay = 0.0f)
+      : lr_(lr), beta1_(beta1), beta2_(beta2), eps_(eps),
+        weight_decay_(weight_decay), t_(0) {}
 
   void zero_grad(const std::vector<Param> &ps);
-  void step(const std::vector<Param> &ps);
+  void step(const std::vector<Param> &ps, bool zero_grad = false);
+
+  // step() split in two, for updating parameters in several groups per
+  // iteration (e.g. layer by layer from Sequential::backward_step):
+  // begin_step() advances the timestep once, update() applies it to a group.
+  void begin_step();
+  void update(const std::vector<Param> &ps, bool zero_grad = false);
+
+  // Bytes of optimizer state currently allocated.
+  size_t state_bytes() const { return (m_.size() + v_.size()) * sizeof(float); }
+
+  // Timestep and per-parameter moments, keyed by parameter name so they
+  // can be restored into tensors at different addresses. import_state()
+  // binds `ps` like a step would; parameters without saved moments start
+  // from zero.
+  void export_state(const std::vector<NamedParam> &ps, TrainingState &out,
+                    const std::string &prefix = "adam/") const;
+  void import_state(const std::vector<NamedParam> &ps, const TrainingState &in,
+                    const std::string &prefix = "adam/");
 
 private:
   float lr_;
   float beta1_;
   float beta2_;
   float eps_;
+  float weight_decay_;
 
-  
   int t_;
-  
-  std::unordered_map<Tensor *, Tensor> m_; 
-  std::unordered_map<Tensor *, Tensor> v_; 
+
+  // First/second moments of every parameter, at the offsets assigned by
+  // slots_.
+  ParamSlots slots_;
+  Storage m_;
+  Storage v_;
 };
 
 }  
@@ -0,0 +1,53 @@
+#pragma once
+#include "nn/module.h"
+#include "optim/param_slots.h"
+#include <cstdint>
+#include <vector>
+
+namespace tf {
+
+// Adam with block-wise 8-bit quantized moments.
+//
+// Both moments are stored as one byte per element plus one fp32 scale per
+// block of kBlock elements (about 2 bytes of state per parameter instead of
+// 8). Codes are non-linear so small values keep resolution:
+//   m = sign(q) * (|q| / 127)^2 * absmax(m)   (int8)
+//   sqrt(v) = (q / 255)^2 * max(sqrt(v))      (uint8, rounded up)
+// The update kernel dequantizes a block, applies the regular Adam update in
+// fp32, recomputes the block scales and requantizes, all in one pass.
+class Adam8bit {
+public:
+  static constexpr size_t kBlock = 256;
+
+  explicit Adam8bit(float lr = 0.001f, float beta1 = 0.9f,
+                    float beta2 = 0.999f, float eps = 1e-8f,
+                    float weight_decay = 0.0f)
+      : lr_(lr), beta1_(beta1), beta2_(beta2), eps_(eps),
+        weight_decay_(weight_decay), t_(0), slots_(kBlock) {}
+
+  void zero_grad(const std::vector<Param> &ps);
+  void step(const std::vector<Param> &ps, bool zero_grad = false);
+
+  void begin_step();
+  void update(const std::vector<Param> &ps, bool zero_grad = false);
+
+  // Bytes of optimizer state currently allocated.
+  size_t state_bytes() const;
+
+private:
+  float lr_;
+  float beta1_;
+  float beta2_;
+  float eps_;
+  float weight_decay_;
+
+  int t_;
+
+  ParamSlots slots_;
+  std::vector<int8_t> m_q_;
+  std::vector<uint8_t> v_q_;
+  std::vector<float> m_scale_; // absmax of m per block
+  std::vector<float> v_scale_; // max of sqrt(v) per block
+};
+
+}  
@@ -0,0 +1,49 @@
+#pragma once
+#include "core/storage.h"
+#include "nn/module.h"
+#include "optim/param_slots.h"
+#include <vector>
+
+namespace tf {
+
+// LAMB (You et al., "Large Batch Optimization for Deep Learning").
+//
+// Adam moments plus a per-tensor trust ratio ||w|| / ||r||, where r is the
+// bias-corrected Adam direction with decoupled weight decay. The moment
+// update and both norm reductions share one pass; a second pass applies
+// the scaled update.
+class LAMB {
+public:
+  explicit LAMB(float lr = 0.001f, float beta1 = 0.9f, float beta2 = 0.999f,
+                float eps = 1e-6f, float weight_decay = 0.0f)
+      : lr_(lr), beta1_(beta1), beta2_(beta2), eps_(eps),
+        weight_decay_(weight_decay), t_(0) {}
+
+  void zero_grad(const std::vector<Param> &ps);
+  void step(const std::vector<Param> &ps, bool zero_grad = false);
+
+  void begin_step();
+  void update(const std::vector<Param> &ps, bool zero_grad = false);
+
+  // Trust ratios applied to each tensor of the last updated group.
+  const std::vector<float> &trust_ratios() const { return trust_; }
+
+private:
+  float lr_;
+  float beta1_;
+  float beta2_;
+  float eps_;
+  float weight_decay_;
+
+  int t_;
+
+  ParamSlots slots_;
+  Storage m_;
+  Storage v_;
+
+  std::vector<double> chunk_w2_;
+  std::vector<double> chunk_r2_;
+  std::vector<float> trust_;
+};
+
+}  
@@ -0,0 +1,46 @@
+#pragma once
+#include "core/storage.h"
+#include "nn/module.h"
+#include "optim/param_slots.h"
+#include <vector>
+
+namespace tf {
+
+// LARS (You et al., "Large Batch Training of Convolutional Networks").
+//
+// SGD with momentum where each tensor's learning rate is scaled by the
+// trust ratio eta * ||w|| / (||g|| + wd * ||w||). Both norms come from one
+// fused reduction pass; a second pass updates momentum and weights.
+class LARS {
+public:
+  explicit LARS(float lr, float momentum = 0.9f, float weight_decay = 0.0f,
+                float eta = 0.001f, float eps = 1e-9f)
+      : lr_(lr), momentum_(momentum), weight_decay_(weight_decay), eta_(eta),
+        eps_(eps) {}
+
+  void zero_grad(const std::vector<Param> &ps);
+  void step(const std::vector<Param> &ps, bool zero_grad = false);
+
+  void begin_step() {}
+  void update(const std::vector<Param> &ps, bool zero_grad = false) {
+    step(ps, zero_grad);
+  }
+
+  const std::vector<float> &trust_ratios() const { return trust_; }
+
+private:
+  float lr_;
+  float momentum_;
+  float weight_decay_;
+  float eta_;
+  float eps_;
+
+  ParamSlots slots_;
+  Storage velocity_;
+
+  std::vector<double> chunk_w2_;
+  std::vector<double> chunk_g2_;
+  std::vector<float> trust_;
+};
+
+}  
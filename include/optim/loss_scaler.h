@@ -0,0 +1,54 @@
+#pragma once
+#include "core/tensor.h"
+#include "nn/module.h"
+#include <vector>
+
+namespace tf {
+
+// Dynamic loss scaling for mixed-precision training.
+//
+// The loss gradient is multiplied by scale() before backward so small
+// gradients survive reduced-precision arithmetic. step() unscales the
+// parameter gradients, skips the optimizer step if any of them overflowed
+// and adapts the scale: backoff on overflow, growth after growth_interval
+// consecutive finite steps.
+class LossScaler {
+public:
+  explicit LossScaler(float init_scale = 65536.0f, float growth_factor = 2.0f,
+                      float backoff_factor = 0.5f, int growth_interval = 2000)
+      : scale_(init_scale), growth_factor_(growth_factor),
+        backoff_factor_(backoff_factor), growth_interval_(growth_interval) {}
+
+  float scale() const { return scale_; }
+  int skipped_steps() const { return skipped_; }
+
+  void scale_grad(Tensor &d_loss) const;
+
+  // Divides grads by scale(); returns false if any gradient is inf/NaN.
+  bool unscale(const std::vector<Param> &ps) const;
+  void update(bool finite);
+
+  // Works with any optimizer exposing step(const std::vector<Param>&).
+  // Returns true if the step was applied. It cannot wrap
+  // Sequential::backward_step, which updates each layer before the
+  // gradients of the whole model are known to be finite.
+  template <class Optim>
+  bool step(Optim &optim, const std::vector<Param> &ps) {
+    const bool finite = unscale(ps);
+    if (finite)
+      optim.step(ps);
+    update(finite);
+    return finite;
+  }
+
+private:
+  float scale_;
+  float growth_factor_;
+  float backoff_factor_;
+  int growth_interval_;
+
+  int good_steps_ = 0;
+  int skipped_ = 0;
+};
+
+}  
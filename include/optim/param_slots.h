@@ -0,0 +1,94 @@
+#pragma once
+#include "nn/module.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace tf {
+
+// Assigns every parameter tensor a fixed offset in an optimizer's flat state
+// buffers (Adam moments, momentum, ...). Offsets are assigned once, the first
+// time a tensor is seen, and never move; stepping the same parameter list
+// again is a pointer compare per tensor, not a hash lookup.
+//
+// bind() also splits the bound list into fixed-size chunks so an update
+// kernel can run over all parameters in a single parallel region. Bindings
+// are cached per distinct list, so cycling through several lists (one per
+// layer with Sequential::backward_step) still costs only pointer compares.
+// At most kMaxBindings lists are cached; the least recently used one is
+// rebuilt on its next bind().
+class ParamSlots {
+public:
+  static constexpr size_t npos = (size_t)-1;
+
+  // Slot offsets are multiples of `align` elements (default: one 64-byte
+  // line of floats). Block-structured state uses its block size here so
+  // no block straddles two tensors.
+  explicit ParamSlots(size_t align = 16) : align_(align) {}
+
+  struct Chunk {
+    size_t param; // index into the bound list
+    size_t begin; // element range inside that tensor
+    size_t end;
+  };
+
+  // Returns true if new slots were appended; state buffers must then grow
+  // to total() elements (existing offsets are unchanged).
+  bool bind(const std::vector<Param> &ps);
+
+  // State offset of ps[i] for the last bound list, npos if ps[i] is skipped
+  // (missing grad or grad/value shape mismatch).
+  size_t offset(size_t i) const { return bindings_[current_].offsets[i]; }
+  const std::vector<Chunk> &chunks() const {
+    return bindings_[current_].chunks;
+  }
+
+  // Total state elements over all slots ever assigned.
+  size_t total() const { return total_; }
+
+  // Parameter lists currently cached.
+  size_t num_bindings() const { return bindings_.size(); }
+
+  // Slot lookup by tensor, npos if the tensor has no slot.
+  size_t find(const Tensor *value) const;
+
+  // Number of elements per chunk handed to one thread. Chunks start at
+  // multiples of kChunk inside each tensor.
+  static constexpr size_t kChunk = 16384;
+
+  // Cached bindings before the least recently used is evicted.
+  static constexpr size_t kMaxBindings = 128;
+
+private:
+  struct Slot {
+    size_t offset;
+    size_t size;
+  };
+
+  // One bound parameter list: what it was bound with (the key) and the
+  // resolved offsets and chunks.
+  struct Binding {
+    std::vector<const Tensor *> values;
+    std::vector<const Tensor *> grads;
+    std::vector<size_t> sizes;      // value elements
+    std::vector<size_t> grad_sizes; // grad elements
+    std::vector<size_t> offsets;
+    std::vector<Chunk> chunks;
+    uint64_t last_used = 0;
+
+    bool matches(const std::vector<Param> &ps) const;
+  };
+
+  bool make_binding(const std::vector<Param> &ps, Binding &b);
+
+  size_t align_;
+  std::unordered_map<const Tensor *, Slot> slots_;
+  size_t total_ = 0;
+
+  std::vector<Binding> bindings_ = std::vector<Binding>(1);
+  size_t current_ = 0;
+  uint64_t tick_ = 0;
+};
+
+}  
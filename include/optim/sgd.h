@@ -1,18 +1,45 @@
 #pragma once
 #include <vector>
+#include "core/storage.h"
 #include "nn/module.h"
+#include "optim/param_slots.h"
 
 namespace tf {
 
+// SGD with optional momentum, Nesterov momentum and weight decay.
+//
+// weight_decay is added to the gradient as an L2 term (wd * value), or with
+// decoupled_weight_decay applied directly to the value as value *= 1 - lr*wd.
+// All of it runs as one fused pass over value, grad and momentum buffer.
 class SGD {
 public:
-  explicit SGD(float lr) : lr_(lr) {}
+  explicit SGD(float lr, float momentum = 0.0f, float weight_decay = 0.0f,
+               bool nesterov = false, bool decoupled_weight_decay = false)
+      : lr_(lr), momentum_(momentum), weight_decay_(weight_decay),
+        nesterov_(nesterov), decoupled_(decoupled_weight_decay) {}
 
   void zero_grad(const std::vector<Param>& ps);
-  void step(const std::vector<Param>& ps);
+
+  // With zero_grad = true the gradients are cleared inside the update pass,
+  // so no separate zero_grad() sweep is needed before the next backward.
+  void step(const std::vector<Param>& ps, bool zero_grad = false);
+
+  // Group-wise stepping interface shared with Adam. SGD has no per-step
+  // state, so begin_step() is a no-op and update() is step().
+  void begin_step() {}
+  void update(const std::vector<Param>& ps, bool zero_grad = false) {
+    step(ps, zero_grad);
+  }
 
 private:
   float lr_;
+  float momentum_;
+  float weight_decay_;
+  bool nesterov_;
+  bool decoupled_;
+
+  ParamSlots slots_;
+  Storage velocity_;
 };
 
 }
@@ -0,0 +1,64 @@
+#include "core/dtype.h"
+#include "core/error.h"
+
+namespace tf {
+
+size_t dtype_size(DType dt) {
+  switch (dt) {
+  case DType::F32:
+    return 4;
+  case DType::BF16:
+    return 2;
+  case DType::U8:
+  case DType::I8:
+    return 1;
+  case DType::F16:
+  case DType::I16:
+    return 2;
+  }
+  THROW_ERROR("Unknown dtype " << (uint32_t)dt);
+}
+
+const char *dtype_name(DType dt) {
+  switch (dt) {
+  case DType::F32:
+    return "f32";
+  case DType::BF16:
+    return "bf16";
+  case DType::U8:
+    return "u8";
+  case DType::F16:
+    return "f16";
+  case DType::I16:
+    return "i16";
+  case DType::I8:
+    return "i8";
+  }
+  return "unknown";
+}
+
+void f32_to_bf16(const float *src, uint16_t *dst, size_t n) {
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = f32_to_bf16(src[i]);
+}
+
+void bf16_to_f32(const uint16_t *src, float *dst, size_t n) {
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = bf16_to_f32(src[i]);
+}
+
+void f32_to_f16(const float *src, uint16_t *dst, size_t n) {
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = f32_to_f16(src[i]);
+}
+
+void f16_to_f32(const uint16_t *src, float *dst, size_t n) {
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = f16_to_f32(src[i]);
+}
+
+}
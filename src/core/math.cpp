@@ -1,38 +1,296 @@
 #include "core/math.h"
+#include "core/dtype.h"
 #include "core/error.h"
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <vector>
 
 namespace tf {
 
+// Multiplications below this many MACs stay on one thread.
+constexpr size_t kParallelGemm = 1 << 15;
+
+static inline float sigmoid_scalar(float x) {
+  if (x >= 0.0f) {
+    float z = std::exp(-x);
+    return 1.0f / (1.0f + z);
+  } else {
+    float z = std::exp(x);
+    return z / (1.0f + z);
+  }
+}
+
+static inline float to_f32(float v) { return v; }
+static inline float to_f32(uint16_t h) { return bf16_to_f32(h); }
+static inline void from_f32(float v, float &out) { out = v; }
+static inline void from_f32(float v, uint16_t &out) { out = f32_to_bf16(v); }
+
+// Packs the K x N matrix whose (k, n) element is src[k * rs + n * cs] into
+// kGemmPanel-wide panels, converting to T.
+template <typename T>
+static void pack_panels(const float *src, int K, int N, size_t rs, size_t cs,
+                        T *dst) {
+  const int panels = (N + kGemmPanel - 1) / kGemmPanel;
+#pragma omp parallel for schedule(static) \
+    if ((size_t)K * N >= kParallelGemm)
+  for (int p = 0; p < panels; ++p) {
+    const int j0 = p * kGemmPanel;
+    const int w = std::min(kGemmPanel, N - j0);
+    T *panel = dst + (size_t)p * K * kGemmPanel;
+    for (int k = 0; k < K; ++k) {
+      const float *row = src + (size_t)k * rs + (size_t)j0 * cs;
+      T *d = panel + (size_t)k * kGemmPanel;
+      for (int j = 0; j < w; ++j)
+        from_f32(row[(size_t)j * cs], d[j]);
+      for (int j = w; j < kGemmPanel; ++j)
+        d[j] = T(0);
+    }
+  }
+}
+
+void pack_b(const Tensor &B, PackedMatrix &out) {
+  out.rows = B.rows;
+  out.cols = B.cols;
+  out.data.resize(PackedMatrix::packed_size(B.rows, B.cols));
+  pack_panels(B.data.data(), B.rows, B.cols, B.cols, 1, out.data.data());
+}
+
+void pack_b_bf16(const Tensor &B, PackedMatrixBF16 &out) {
+  out.rows = B.rows;
+  out.cols = B.cols;
+  out.data.resize(PackedMatrix::packed_size(B.rows, B.cols));
+  pack_panels(B.data.data(), B.rows, B.cols, B.cols, 1, out.data.data());
+}
+
+void pack_bt_bf16(const Tensor &B, PackedMatrixBF16 &out) {
+  out.rows = B.cols;
+  out.cols = B.rows;
+  out.data.resize(PackedMatrix::packed_size(B.cols, B.rows));
+  pack_panels(B.data.data(), B.cols, B.rows, 1, B.cols, out.data.data());
+}
+
+static inline float activate(float v, Activation act) {
+  switch (act) {
+  case Activation::ReLU:
+    return v > 0.0f ? v : 0.0f;
+  case Activation::Sigmoid:
+    return sigmoid_scalar(v);
+  default:
+    return v;
+  }
+}
+
+// MR rows of A times one packed panel, accumulated in registers
+// (MR x kGemmPanel floats) over the whole K dimension, then written as
+// act(acc + bias). With one or two rows a single accumulator set leaves the
+// FMAs waiting on each other, so even and odd k go to separate sets.
+template <int MR, typename TA, typename TB>
+static void gemm_block(const TA *A, int lda, const TB *panel, int K,
+                       float *C, int ldc, int width, const float *bias,
+                       Activation act) {
+  constexpr int KU = MR <= 2 ? 2 : 1;
+  float acc[KU][MR][kGemmPanel] = {};
+  int k = 0;
+  for (; k + KU <= K; k += KU) {
+    for (int u = 0; u < KU; ++u) {
+      const TB *b = panel + (size_t)(k + u) * kGemmPanel;
+      for (int r = 0; r < MR; ++r) {
+        const float a = to_f32(A[(size_t)r * lda + k + u]);
+#pragma omp simd
+        for (int j = 0; j < kGemmPanel; ++j)
+          acc[u][r][j] += a * to_f32(b[j]);
+      }
+    }
+  }
+  for (; k < K; ++k) {
+    const TB *b = panel + (size_t)k * kGemmPanel;
+    for (int r = 0; r < MR; ++r) {
+      const float a = to_f32(A[(size_t)r * lda + k]);
+#pragma omp simd
+      for (int j = 0; j < kGemmPanel; ++j)
+        acc[0][r][j] += a * to_f32(b[j]);
+    }
+  }
+  for (int r = 0; r < MR; ++r) {
+    float *row = C + (size_t)r * ldc;
+    for (int j = 0; j < width; ++j) {
+      float v = acc[0][r][j] + (bias ? bias[j] : 0.0f);
+      for (int u = 1; u < KU; ++u)
+        v += acc[u][r][j];
+      row[j] = activate(v, act);
+    }
+  }
+}
+
+static void check_bias(const Tensor &bias, int N) {
+  CHECK(bias.size() == 0 || (bias.rows == 1 && bias.cols == N),
+        "matmul bias mismatch: " << bias.shape_str() << " for N=" << N);
+}
+
+void matmul_packed(const Tensor &A, const PackedMatrix &B, Tensor &C) {
+  matmul_packed(A, B, Tensor(), Activation::None, C);
+}
+
+// C (M x N) = act(A * B + bias) over B's panels, for fp32 or bf16 operands.
+template <typename TA, typename TB>
+static void gemm_packed(const TA *a, int M, int K, const TB *b, int N,
+                        const float *bp, Activation act, float *c) {
+  constexpr int MR = 4;
+  const int row_blocks = (M + MR - 1) / MR;
+  const int panels = (N + kGemmPanel - 1) / kGemmPanel;
+  const long tasks = (long)row_blocks * panels;
+
+  // Consecutive tasks share a panel, so with a static schedule each thread
+  // streams one panel of B through cache across its row blocks.
+#pragma omp parallel for schedule(static) \
+    if ((size_t)M * N * K >= kParallelGemm && tasks > 1)
+  for (long t = 0; t < tasks; ++t) {
+    const int p = (int)(t / row_blocks);
+    const int i0 = (int)(t % row_blocks) * MR;
+    const int j0 = p * kGemmPanel;
+    const int width = std::min(kGemmPanel, N - j0);
+    const TB *panel = b + (size_t)p * K * kGemmPanel;
+    const TA *ap = a + (size_t)i0 * K;
+    const float *bias_p = bp ? bp + j0 : nullptr;
+    float *cp = c + (size_t)i0 * N + j0;
+    switch (std::min(MR, M - i0)) {
+    case 4:
+      gemm_block<4>(ap, K, panel, K, cp, N, width, bias_p, act);
+      break;
+    case 3:
+      gemm_block<3>(ap, K, panel, K, cp, N, width, bias_p, act);
+      break;
+    case 2:
+      gemm_block<2>(ap, K, panel, K, cp, N, width, bias_p, act);
+      break;
+    default:
+      gemm_block<1>(ap, K, panel, K, cp, N, width, bias_p, act);
+      break;
+    }
+  }
+}
+
+void matmul_packed(const Tensor &A, const PackedMatrix &B, const Tensor &bias,
+                   Activation act, Tensor &C) {
+  CHECK(A.cols == B.rows,
+        "matmul mismatch: " << A.shape_str() << " * (" << B.rows << ","
+                            << B.cols << ")");
+  check_bias(bias, B.cols);
+  C.resize(A.rows, B.cols);
+  gemm_packed(A.data.data(), A.rows, A.cols, B.data.data(), B.cols,
+              bias.size() ? bias.data.data() : nullptr, act, C.data.data());
+}
+
+void matmul_packed_bf16(const uint16_t *A, int M, int K,
+                        const PackedMatrixBF16 &B, const Tensor &bias,
+                        Activation act, Tensor &C) {
+  CHECK(K == B.rows, "matmul_bf16 mismatch: (" << M << "," << K << ") * ("
+                                               << B.rows << "," << B.cols
+                                               << ")");
+  check_bias(bias, B.cols);
+  C.resize(M, B.cols);
+  gemm_packed(A, M, K, B.data.data(), B.cols,
+              bias.size() ? bias.data.data() : nullptr, act, C.data.data());
+}
+
 Tensor matmul(const Tensor &A, const Tensor &B) {
   CHECK(A.cols == B.rows,
         "matmul mismatch: " << A.shape_str() << " * " << B.shape_str());
-  Tensor C(A.rows, B.cols, 0.0f);
-
-  
-  
-  Tensor Bt = transpose(B);
-
-#pragma omp parallel for schedule(static)
-  for (int i = 0; i < A.rows; ++i) {
-    const size_t a_row_offset = (size_t)i * (size_t)A.cols;
-    const float *A_ptr = A.data.data() + a_row_offset;
-
-    for (int j = 0; j < B.cols; ++j) {
-      const size_t b_row_offset =
-          (size_t)j *
-          (size_t)Bt.cols; 
-      const float *B_ptr = Bt.data.data() + b_row_offset;
-
-      float sum = 0.0f;
-      for (int k = 0; k < A.cols; ++k) {
-        sum += A_ptr[k] * B_ptr[k];
+  PackedMatrix Bp;
+  pack_b(B, Bp);
+  Tensor C;
+  matmul_packed(A, Bp, C);
+  return C;
+}
+
+// Column block owned by one matmul_skinny task.
+constexpr int kSkinnyBlock = 64;
+
+// acc[MR][NB] = A[MR, K] * B[K, width] read straight from row-major B: each
+// k touches one contiguous run of B, and the NB-wide accumulator rows give
+// the FMAs enough independent chains.
+template <int MR, int NB>
+static void skinny_block(const float *A, int lda, const float *B, int ldb,
+                         int K, float *C, int ldc, int width,
+                         const float *bias, Activation act) {
+  float acc[MR][NB] = {};
+  if (width == NB) {
+    for (int k = 0; k < K; ++k) {
+      const float *b = B + (size_t)k * ldb;
+      for (int r = 0; r < MR; ++r) {
+        const float a = A[(size_t)r * lda + k];
+#pragma omp simd
+        for (int j = 0; j < NB; ++j)
+          acc[r][j] += a * b[j];
+      }
+    }
+  } else {
+    for (int k = 0; k < K; ++k) {
+      const float *b = B + (size_t)k * ldb;
+      for (int r = 0; r < MR; ++r) {
+        const float a = A[(size_t)r * lda + k];
+#pragma omp simd
+        for (int j = 0; j < width; ++j)
+          acc[r][j] += a * b[j];
       }
+    }
+  }
+  for (int r = 0; r < MR; ++r) {
+    float *row = C + (size_t)r * ldc;
+    for (int j = 0; j < width; ++j)
+      row[j] = activate(acc[r][j] + (bias ? bias[j] : 0.0f), act);
+  }
+}
+
+void matmul_skinny(const Tensor &A, const Tensor &B, const Tensor &bias,
+                   Activation act, Tensor &C) {
+  CHECK(A.cols == B.rows,
+        "matmul mismatch: " << A.shape_str() << " * " << B.shape_str());
+  check_bias(bias, B.cols);
+  const int M = A.rows, K = A.cols, N = B.cols;
+  C.resize(M, N);
+  const int blocks = (N + kSkinnyBlock - 1) / kSkinnyBlock;
+  const float *a = A.data.data();
+  const float *b = B.data.data();
+  const float *bp = bias.size() ? bias.data.data() : nullptr;
+  float *c = C.data.data();
 
-      C(i, j) = sum;
+  // One task per column block, so a thread reads its slice of every row of
+  // B exactly once per pair of rows of A.
+#pragma omp parallel for schedule(static) \
+    if ((size_t)M * N * K >= kParallelGemm && blocks > 1)
+  for (int t = 0; t < blocks; ++t) {
+    const int j0 = t * kSkinnyBlock;
+    const int width = std::min(kSkinnyBlock, N - j0);
+    const float *bias_p = bp ? bp + j0 : nullptr;
+    for (int i = 0; i < M;) {
+      const float *ap = a + (size_t)i * K;
+      float *cp = c + (size_t)i * N + j0;
+      if (M - i >= 2) {
+        skinny_block<2, kSkinnyBlock>(ap, K, b + j0, N, K, cp, N, width,
+                                      bias_p, act);
+        i += 2;
+      } else {
+        skinny_block<1, kSkinnyBlock>(ap, K, b + j0, N, K, cp, N, width,
+                                      bias_p, act);
+        i += 1;
+      }
     }
   }
+}
+
+Tensor matmul_bf16(const Tensor &A, const Tensor &B) {
+  CHECK(A.cols == B.rows,
+        "matmul_bf16 mismatch: " << A.shape_str() << " * " << B.shape_str());
+  std::vector<uint16_t> Ah(A.size());
+  f32_to_bf16(A.data.data(), Ah.data(), A.size());
+  PackedMatrixBF16 Bp;
+  pack_b_bf16(B, Bp);
+  Tensor C;
+  matmul_packed_bf16(Ah.data(), A.rows, A.cols, Bp, Tensor(), Activation::None,
+                     C);
   return C;
 }
 
@@ -53,6 +311,15 @@ Tensor add(const Tensor &A, const Tensor &B) {
   return C;
 }
 
+void add_inplace(Tensor &A, const Tensor &B) {
+  CHECK(A.rows == B.rows && A.cols == B.cols,
+        "add_inplace mismatch: " << A.shape_str() << " += " << B.shape_str());
+  float *a = A.data.data();
+  const float *b = B.data.data();
+  for (size_t i = 0; i < A.size(); ++i)
+    a[i] += b[i];
+}
+
 Tensor sub(const Tensor &A, const Tensor &B) {
   CHECK(A.rows == B.rows && A.cols == B.cols,
         "sub mismatch: " << A.shape_str() << " - " << B.shape_str());
@@ -93,6 +360,18 @@ Tensor add_bias_rowwise(const Tensor &X, const Tensor &b) {
   return Y;
 }
 
+void add_bias_rowwise_(Tensor &X, const Tensor &b) {
+  CHECK(b.rows == 1 && b.cols == X.cols,
+        "add_bias_rowwise_ mismatch: X=" << X.shape_str()
+                                         << ", b=" << b.shape_str());
+  const float *bp = b.data.data();
+  for (int i = 0; i < X.rows; ++i) {
+    float *row = X.data.data() + (size_t)i * X.cols;
+    for (int j = 0; j < X.cols; ++j)
+      row[j] += bp[j];
+  }
+}
+
 Tensor sum_rows(const Tensor &X) {
   Tensor s(1, X.cols, 0.0f);
   for (int i = 0; i < X.rows; ++i) {
@@ -111,6 +390,11 @@ Tensor relu(const Tensor &X) {
   return Y;
 }
 
+void relu_(Tensor &X) {
+  for (auto &x : X.data)
+    x = x > 0.0f ? x : 0.0f;
+}
+
 Tensor relu_backward(const Tensor &X, const Tensor &dY) {
   CHECK(X.rows == dY.rows && X.cols == dY.cols,
         "relu_backward mismatch: X=" << X.shape_str()
@@ -121,16 +405,6 @@ Tensor relu_backward(const Tensor &X, const Tensor &dY) {
   return dX;
 }
 
-static inline float sigmoid_scalar(float x) {
-  if (x >= 0.0f) {
-    float z = std::exp(-x);
-    return 1.0f / (1.0f + z);
-  } else {
-    float z = std::exp(x);
-    return z / (1.0f + z);
-  }
-}
-
 Tensor sigmoid(const Tensor &X) {
   Tensor Y(X.rows, X.cols);
   for (size_t i = 0; i < X.size(); ++i)
@@ -138,6 +412,11 @@ Tensor sigmoid(const Tensor &X) {
   return Y;
 }
 
+void sigmoid_(Tensor &X) {
+  for (auto &x : X.data)
+    x = sigmoid_scalar(x);
+}
+
 Tensor sigmoid_backward_from_output(const Tensor &sigmoid_out,
                                     const Tensor &dY) {
   CHECK(sigmoid_out.rows == dY.rows && sigmoid_out.cols == dY.cols,
@@ -1,21 +1,146 @@
 #include "core/rng.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace tf {
 
+namespace {
 
+// Below this many outputs a fill runs on the calling thread.
+constexpr size_t kParallelFill = 1 << 16;
+
+constexpr float kTwoPi = 6.28318530717958647692f;
+
+inline float to_unit(uint32_t x) { return (x >> 8) * (1.0f / 16777216.0f); }
+
+// (0, 1]: safe for log().
+inline float to_unit_open(uint32_t x) {
+  return ((x >> 8) + 1) * (1.0f / 16777216.0f);
+}
+
+}  
+
+float RNG::normal() {
+  const float u1 = to_unit_open(next_u32());
+  const float u2 = to_unit(next_u32());
+  return std::sqrt(-2.0f * std::log(u1)) * std::cos(kTwoPi * u2);
+}
+
+namespace {
+
+// Philox over kLanes consecutive blocks at once, structure-of-arrays so the
+// rounds vectorize: out[w][l] is word w of block first + l.
+constexpr int kLanes = 16;
+
+void philox_lanes(uint64_t key, uint64_t stream, uint64_t first,
+                  uint32_t out[4][kLanes]) {
+  uint32_t c0[kLanes], c1[kLanes], c2[kLanes], c3[kLanes];
+#pragma omp simd
+  for (int l = 0; l < kLanes; ++l) {
+    const uint64_t b = first + (uint64_t)l;
+    c0[l] = (uint32_t)b;
+    c1[l] = (uint32_t)(b >> 32);
+    c2[l] = (uint32_t)stream;
+    c3[l] = (uint32_t)(stream >> 32);
+  }
+  uint32_t k0 = (uint32_t)key, k1 = (uint32_t)(key >> 32);
+  for (int r = 0; r < 10; ++r) {
+#pragma omp simd
+    for (int l = 0; l < kLanes; ++l) {
+      const uint64_t p0 = (uint64_t)0xD2511F53u * c0[l];
+      const uint64_t p1 = (uint64_t)0xCD9E8D57u * c2[l];
+      const uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1[l] ^ k0;
+      const uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3[l] ^ k1;
+      c1[l] = (uint32_t)p1;
+      c3[l] = (uint32_t)p0;
+      c0[l] = n0;
+      c2[l] = n2;
+    }
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+  for (int l = 0; l < kLanes; ++l) {
+    out[0][l] = c0[l];
+    out[1][l] = c1[l];
+    out[2][l] = c2[l];
+    out[3][l] = c3[l];
+  }
+}
+
+// Runs fn(first_value_index, words[4][kLanes]) over every group of kLanes
+// blocks covering n values; groups are independent, so they are spread
+// across threads for large n.
+template <typename Fn>
+void for_each_group(uint64_t key, uint64_t stream, uint64_t first, size_t n,
+                    Fn fn) {
+  const size_t per_group = 4 * kLanes;
+  const long groups = (long)((n + per_group - 1) / per_group);
+#pragma omp parallel for schedule(static) if (n >= kParallelFill)
+  for (long g = 0; g < groups; ++g) {
+    uint32_t words[4][kLanes];
+    philox_lanes(key, stream, first + (uint64_t)g * kLanes, words);
+    fn((size_t)g * per_group, words);
+  }
+}
+
+}  
+
+// Value i of a fill is word i % 4 of block first + i / 4, the same as the
+// scalar sequence.
+void RNG::fill_uniform(float *dst, size_t n, float lo, float hi) {
+  const float scale = hi - lo;
+  for_each_group(key, stream, block, n,
+                 [&](size_t at, const uint32_t (*w)[kLanes]) {
+                   float tmp[4 * kLanes];
+#pragma omp simd
+                   for (int l = 0; l < kLanes; ++l)
+                     for (int k = 0; k < 4; ++k)
+                       tmp[4 * l + k] = lo + scale * to_unit(w[k][l]);
+                   const size_t m = std::min(n - at, (size_t)(4 * kLanes));
+                   std::memcpy(dst + at, tmp, m * sizeof(float));
+                 });
+  block += (n + 3) / 4;
+  idx = 4;
+}
+
+// Box-Muller on both halves of each block: 4 words give 4 normals.
+void RNG::fill_normal(float *dst, size_t n, float mean, float stddev) {
+  for_each_group(key, stream, block, n,
+                 [&](size_t at, const uint32_t (*w)[kLanes]) {
+                   float tmp[4 * kLanes];
+                   float z[4][kLanes];
+                   for (int p = 0; p < 2; ++p) {
+#pragma omp simd
+                     for (int l = 0; l < kLanes; ++l) {
+                       const float rad = std::sqrt(
+                           -2.0f * std::log(to_unit_open(w[2 * p][l])));
+                       const float th = kTwoPi * to_unit(w[2 * p + 1][l]);
+                       z[2 * p][l] = mean + stddev * rad * std::cos(th);
+                       z[2 * p + 1][l] = mean + stddev * rad * std::sin(th);
+                     }
+                   }
+                   for (int l = 0; l < kLanes; ++l)
+                     for (int k = 0; k < 4; ++k)
+                       tmp[4 * l + k] = z[k][l];
+                   const size_t m = std::min(n - at, (size_t)(4 * kLanes));
+                   std::memcpy(dst + at, tmp, m * sizeof(float));
+                 });
+  block += (n + 3) / 4;
+  idx = 4;
+}
 
 void xavier_uniform_(Tensor& W, RNG& rng) {
   const float fan_in  = (float)W.rows;
   const float fan_out = (float)W.cols;
   const float limit = std::sqrt(6.0f / (fan_in + fan_out));
-  for (auto& v : W.data) v = rng.uniform(-limit, limit);
+  rng.fill_uniform(W.data.data(), W.size(), -limit, limit);
 }
 
 void he_uniform_(Tensor& W, RNG& rng) {
   const float fan_in = (float)W.rows;
   const float limit = std::sqrt(6.0f / fan_in);
-  for (auto& v : W.data) v = rng.uniform(-limit, limit);
+  rng.fill_uniform(W.data.data(), W.size(), -limit, limit);
 }
 
 }
@@ -0,0 +1,129 @@
+#include "core/storage.h"
+#include "core/error.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace tf {
+
+float *aligned_alloc_floats(size_t n) {
+  if (n == 0)
+    return nullptr;
+  return static_cast<float *>(::operator new(
+      n * sizeof(float), std::align_val_t(Storage::kAlignment)));
+}
+
+void aligned_free_floats(float *p) {
+  if (p)
+    ::operator delete(p, std::align_val_t(Storage::kAlignment));
+}
+
+Storage::Storage(size_t n, float fill)
+    : ptr_(aligned_alloc_floats(n)), size_(n), capacity_(n) {
+  std::fill(ptr_, ptr_ + n, fill);
+}
+
+Storage::~Storage() { release(); }
+
+void Storage::release() {
+  if (owns_)
+    aligned_free_floats(ptr_);
+  ptr_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
+  owns_ = true;
+}
+
+Storage::Storage(const Storage &other)
+    : ptr_(aligned_alloc_floats(other.size_)), size_(other.size_),
+      capacity_(other.size_) {
+  if (size_)
+    std::memcpy(ptr_, other.ptr_, size_ * sizeof(float));
+}
+
+Storage &Storage::operator=(const Storage &other) {
+  if (this == &other)
+    return *this;
+  if (!owns_ && ptr_) {
+    // A view keeps pointing at the memory it borrows (e.g. a parameter
+    // arena): copy into it rather than detaching.
+    CHECK(size_ == other.size_, "Cannot assign " << other.size_
+                                    << " floats to a view of " << size_);
+  } else if (owns_ && capacity_ >= other.size_) {
+    size_ = other.size_;
+  } else {
+    release();
+    ptr_ = aligned_alloc_floats(other.size_);
+    size_ = capacity_ = other.size_;
+  }
+  if (size_)
+    std::memmove(ptr_, other.ptr_, size_ * sizeof(float));
+  return *this;
+}
+
+Storage::Storage(Storage &&other) noexcept
+    : ptr_(other.ptr_), size_(other.size_), capacity_(other.capacity_),
+      owns_(other.owns_) {
+  other.ptr_ = nullptr;
+  other.size_ = 0;
+  other.capacity_ = 0;
+  other.owns_ = true;
+}
+
+Storage &Storage::operator=(Storage &&other) {
+  if (this == &other)
+    return *this;
+  if (is_view())
+    return *this = static_cast<const Storage &>(other);
+  rebind(std::move(other));
+  return *this;
+}
+
+void Storage::rebind(Storage &&other) noexcept {
+  if (this != &other) {
+    release();
+    ptr_ = other.ptr_;
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    owns_ = other.owns_;
+    other.ptr_ = nullptr;
+    other.size_ = 0;
+    other.capacity_ = 0;
+    other.owns_ = true;
+  }
+}
+
+Storage Storage::view(float *ptr, size_t n) {
+  Storage s;
+  s.ptr_ = ptr;
+  s.size_ = n;
+  s.capacity_ = n;
+  s.owns_ = false;
+  return s;
+}
+
+void Storage::resize(size_t n) {
+  if (is_view()) {
+    CHECK(n == size_, "Cannot resize a view of " << size_ << " floats to "
+                                                 << n << "; rebind it first");
+    return;
+  }
+  if (owns_ && n <= capacity_) {
+    if (n > size_)
+      std::fill(ptr_ + size_, ptr_ + n, 0.0f);
+    size_ = n;
+    return;
+  }
+  float *fresh = aligned_alloc_floats(n);
+  const size_t keep = std::min(size_, n);
+  if (keep)
+    std::memcpy(fresh, ptr_, keep * sizeof(float));
+  std::fill(fresh + keep, fresh + n, 0.0f);
+  release();
+  ptr_ = fresh;
+  size_ = capacity_ = n;
+}
+
+void Storage::clear() { release(); }
+
+}  
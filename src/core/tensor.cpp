@@ -16,16 +16,31 @@ Tensor::Tensor(Tensor&& other) noexcept
   other.cols = 0;
 }
 
-Tensor& Tensor::operator=(Tensor&& other) noexcept {
+Tensor& Tensor::operator=(const Tensor& other) {
+  data = other.data; // may throw for a mismatched view; keep the shape then
+  rows = other.rows;
+  cols = other.cols;
+  return *this;
+}
+
+Tensor& Tensor::operator=(Tensor&& other) {
+  if (this != &other) {
+    if (is_view())
+      return *this = static_cast<const Tensor&>(other);
+    rebind(std::move(other));
+  }
+  return *this;
+}
+
+void Tensor::rebind(Tensor&& other) noexcept {
   if (this != &other) {
     rows = other.rows;
     cols = other.cols;
-    data = std::move(other.data);
-    
+    data.rebind(std::move(other.data));
+
     other.rows = 0;
     other.cols = 0;
   }
-  return *this;
 }
 
 }
\ No newline at end of file
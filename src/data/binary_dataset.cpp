@@ -0,0 +1,272 @@
+#include "data/binary_dataset.h"
+#include "core/error.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace tf {
+
+namespace {
+
+const char MAGIC[] = "TNDS";
+const uint32_t VERSION = 1;
+
+// Below this many gathered floats a batch is copied on the calling thread.
+constexpr size_t kParallelGather = 1 << 15;
+
+uint64_t align_up(uint64_t v, uint64_t a) { return (v + a - 1) / a * a; }
+
+void write_zeros(std::ofstream &out, size_t n) {
+  static const char zeros[BinaryDatasetWriter::kBlockAlign] = {0};
+  while (n > 0) {
+    size_t k = std::min(n, sizeof(zeros));
+    out.write(zeros, k);
+    n -= k;
+  }
+}
+
+}  
+
+BinaryDatasetWriter::BinaryDatasetWriter(const std::string &path, int x_cols,
+                                         int y_cols, DType x_dtype,
+                                         float x_scale, float x_bias)
+    : path_(path), y_path_(path + ".ytmp") {
+  CHECK(x_cols > 0 && y_cols >= 0, "Invalid dataset shape " << x_cols << "x"
+                                                            << y_cols);
+  CHECK(x_dtype == DType::F32 || x_dtype == DType::U8,
+        "Unsupported feature dtype " << dtype_name(x_dtype));
+  CHECK(x_scale != 0.0f, "x_scale must be non-zero");
+
+  std::memset(&header_, 0, sizeof(header_));
+  std::memcpy(header_.magic, MAGIC, 4);
+  header_.version = VERSION;
+  header_.x_cols = (uint32_t)x_cols;
+  header_.y_cols = (uint32_t)y_cols;
+  header_.x_dtype = (uint32_t)x_dtype;
+  header_.y_dtype = (uint32_t)DType::F32;
+  header_.x_offset = kBlockAlign;
+  header_.x_scale = x_scale;
+  header_.x_bias = x_bias;
+
+  out_.open(path_, std::ios::binary | std::ios::trunc);
+  CHECK(out_.is_open(), "Could not open file for writing: " << path_);
+  y_out_.open(y_path_, std::ios::binary | std::ios::trunc);
+  CHECK(y_out_.is_open(), "Could not open file for writing: " << y_path_);
+  // Placeholder header; rewritten by finish().
+  write_zeros(out_, kBlockAlign);
+}
+
+BinaryDatasetWriter::~BinaryDatasetWriter() {
+  if (!finished_) {
+    try {
+      finish();
+    } catch (...) {
+    }
+  }
+}
+
+void BinaryDatasetWriter::append(const float *x, const float *y, size_t n) {
+  CHECK(!finished_, "append after finish");
+  const size_t xn = n * header_.x_cols;
+  if ((DType)header_.x_dtype == DType::F32) {
+    out_.write(reinterpret_cast<const char *>(x), xn * sizeof(float));
+  } else {
+    encode_buf_.resize(xn);
+    const float inv = 1.0f / header_.x_scale;
+    const float bias = header_.x_bias;
+    uint8_t *q = encode_buf_.data();
+#pragma omp simd
+    for (size_t i = 0; i < xn; ++i) {
+      float c = std::floor((x[i] - bias) * inv + 0.5f);
+      q[i] = (uint8_t)std::min(std::max(c, 0.0f), 255.0f);
+    }
+    out_.write(reinterpret_cast<const char *>(q), xn);
+  }
+  y_out_.write(reinterpret_cast<const char *>(y),
+               n * header_.y_cols * sizeof(float));
+  CHECK(out_.good() && y_out_.good(), "Write failed for " << path_);
+  rows_ += n;
+}
+
+void BinaryDatasetWriter::append(const Tensor &x, const Tensor &y) {
+  CHECK(x.rows == y.rows, "append: row mismatch " << x.shape_str() << " vs "
+                                                  << y.shape_str());
+  CHECK(x.cols == (int)header_.x_cols && y.cols == (int)header_.y_cols,
+        "append: expected " << header_.x_cols << " / " << header_.y_cols
+                            << " columns, got " << x.shape_str() << " / "
+                            << y.shape_str());
+  append(x.data.data(), y.data.data(), (size_t)x.rows);
+}
+
+void BinaryDatasetWriter::finish() {
+  if (finished_)
+    return;
+  finished_ = true;
+
+  const uint64_t x_bytes =
+      rows_ * header_.x_cols * dtype_size((DType)header_.x_dtype);
+  header_.rows = rows_;
+  header_.y_offset = align_up(header_.x_offset + x_bytes, kBlockAlign);
+  write_zeros(out_, header_.y_offset - header_.x_offset - x_bytes);
+
+  y_out_.close();
+  {
+    std::ifstream y_in(y_path_, std::ios::binary);
+    CHECK(y_in.is_open(), "Could not reopen " << y_path_);
+    std::vector<char> buf(1 << 20);
+    while (y_in) {
+      y_in.read(buf.data(), buf.size());
+      out_.write(buf.data(), y_in.gcount());
+    }
+  }
+  std::remove(y_path_.c_str());
+
+  out_.seekp(0);
+  out_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+  out_.close();
+  CHECK(!out_.fail(), "Failed to finalize " << path_);
+}
+
+void save_binary_dataset(const TensorDataset &ds, const std::string &path,
+                         DType x_dtype, float x_scale, float x_bias) {
+  BinaryDatasetWriter w(path, ds.features().cols, ds.targets().cols, x_dtype,
+                        x_scale, x_bias);
+  w.append(ds.features(), ds.targets());
+  w.finish();
+}
+
+MmapDataset::MmapDataset(const std::string &path, Access access)
+    : file_(path) {
+  CHECK(file_.size() >= sizeof(BinaryDatasetHeader),
+        "Invalid dataset file (too small): " << path);
+  BinaryDatasetHeader h;
+  std::memcpy(&h, file_.data(), sizeof(h));
+  CHECK(std::memcmp(h.magic, MAGIC, 4) == 0,
+        "Invalid dataset file: wrong magic header in " << path);
+  CHECK(h.version == VERSION, "Unsupported dataset version: " << h.version);
+  CHECK((DType)h.x_dtype == DType::F32 || (DType)h.x_dtype == DType::U8,
+        "Unsupported feature dtype " << h.x_dtype);
+  CHECK((DType)h.y_dtype == DType::F32,
+        "Unsupported target dtype " << h.y_dtype);
+
+  rows_ = h.rows;
+  x_cols_ = (int)h.x_cols;
+  y_cols_ = (int)h.y_cols;
+  x_dtype_ = (DType)h.x_dtype;
+  x_scale_ = h.x_scale;
+  x_bias_ = h.x_bias;
+
+  const uint64_t x_bytes = rows_ * x_cols_ * dtype_size(x_dtype_);
+  const uint64_t y_bytes = rows_ * y_cols_ * sizeof(float);
+  CHECK(h.x_offset + x_bytes <= h.y_offset &&
+            h.y_offset + y_bytes <= file_.size(),
+        "Truncated dataset file: " << path);
+  CHECK(h.x_offset % sizeof(float) == 0 && h.y_offset % sizeof(float) == 0,
+        "Misaligned dataset blocks in " << path);
+
+  x_base_ = file_.data() + h.x_offset;
+  y_base_ = reinterpret_cast<const float *>(file_.data() + h.y_offset);
+  access_ = access;
+  file_.advise(access);
+}
+
+void MmapDataset::set_zero_copy(bool on) {
+  if (on && !zero_copy_) {
+    // Views hand out writable pointers, so the mapping must be private.
+    const size_t x_off = (size_t)(x_base_ - file_.data());
+    const size_t y_off = (size_t)((const uint8_t *)y_base_ - file_.data());
+    file_ = MappedFile(file_.path(), /*copy_on_write=*/true);
+    x_base_ = file_.data() + x_off;
+    y_base_ = reinterpret_cast<const float *>(file_.data() + y_off);
+    file_.advise(access_);
+  }
+  zero_copy_ = on;
+}
+
+Sample MmapDataset::get(size_t i) const {
+  CHECK(i < rows_, "Index out of bounds");
+  Sample s{Tensor(1, x_cols_), Tensor(1, y_cols_)};
+  gather_x(&i, 1, s.x.data.data());
+  std::memcpy(s.y.data.data(), y_base_ + i * y_cols_,
+              (size_t)y_cols_ * sizeof(float));
+  return s;
+}
+
+void MmapDataset::will_need(size_t begin, size_t n) const {
+  if (begin >= rows_)
+    return;
+  n = std::min(n, rows_ - begin);
+  const size_t xs = (size_t)x_cols_ * dtype_size(x_dtype_);
+  const size_t ys = (size_t)y_cols_ * sizeof(float);
+  file_.prefetch((size_t)(x_base_ - file_.data()) + begin * xs, n * xs);
+  file_.prefetch((size_t)((const uint8_t *)y_base_ - file_.data()) + begin * ys,
+                 n * ys);
+}
+
+void MmapDataset::gather_x(const size_t *idx, size_t n, float *dst) const {
+  const size_t cols = (size_t)x_cols_;
+  const bool parallel = n * cols >= kParallelGather;
+  if (x_dtype_ == DType::F32) {
+    const float *src = reinterpret_cast<const float *>(x_base_);
+#pragma omp parallel for schedule(static) if (parallel)
+    for (long k = 0; k < (long)n; ++k)
+      std::memcpy(dst + k * cols, src + idx[k] * cols, cols * sizeof(float));
+    return;
+  }
+  const float scale = x_scale_;
+  const float bias = x_bias_;
+#pragma omp parallel for schedule(static) if (parallel)
+  for (long k = 0; k < (long)n; ++k) {
+    const uint8_t *q = x_base_ + idx[k] * cols;
+    float *d = dst + k * cols;
+#pragma omp simd
+    for (size_t j = 0; j < cols; ++j)
+      d[j] = (float)q[j] * scale + bias;
+  }
+}
+
+void MmapDataset::get_batch(const size_t *idx, size_t n, Tensor &x,
+                            Tensor &y) const {
+  for (size_t k = 0; k < n; ++k)
+    CHECK(idx[k] < rows_, "Index out of bounds: " << idx[k]);
+
+  bool consecutive = n > 0;
+  for (size_t k = 1; k < n && consecutive; ++k)
+    consecutive = idx[k] == idx[0] + k;
+
+  // Buffers that are views from an earlier zero-copy batch are dropped,
+  // never written: they alias the mapping.
+  if (x.is_view())
+    x.rebind(Tensor());
+  if (y.is_view())
+    y.rebind(Tensor());
+
+  if (consecutive && zero_copy_) {
+    // Views into the copy-on-write mapping; see the class comment.
+    uint8_t *base = file_.mutable_data();
+    if (x_dtype_ == DType::F32) {
+      float *px = reinterpret_cast<float *>(base + (x_base_ - file_.data())) +
+                  idx[0] * x_cols_;
+      x.rebind(Tensor::view(px, (int)n, x_cols_));
+    } else {
+      x.resize((int)n, x_cols_);
+      gather_x(idx, n, x.data.data());
+    }
+    float *py = reinterpret_cast<float *>(
+                    base + ((const uint8_t *)y_base_ - file_.data())) +
+                idx[0] * y_cols_;
+    y.rebind(Tensor::view(py, (int)n, y_cols_));
+    return;
+  }
+
+  x.resize((int)n, x_cols_);
+  y.resize((int)n, y_cols_);
+  gather_x(idx, n, x.data.data());
+  float *yd = y.data.data();
+  for (size_t k = 0; k < n; ++k)
+    std::memcpy(yd + k * y_cols_, y_base_ + idx[k] * y_cols_,
+                (size_t)y_cols_ * sizeof(float));
+}
+
+}  
@@ -0,0 +1,166 @@
+#include "data/compact_dataset.h"
+#include "core/error.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace tf {
+
+namespace {
+
+// Below this many gathered floats a batch is decoded on the calling thread.
+constexpr size_t kParallelGather = 1 << 15;
+
+struct DecodeU8 {
+  float operator()(uint8_t q) const { return (float)q; }
+};
+struct DecodeI16 {
+  float operator()(int16_t q) const { return (float)q; }
+};
+struct DecodeF16 {
+  float operator()(uint16_t q) const { return f16_to_f32(q); }
+};
+
+template <typename Code, typename Decode>
+void decode(const uint8_t *codes, int cols, const float *scale,
+            const float *offset, const size_t *idx, size_t n, float *dst) {
+  const Code *base = reinterpret_cast<const Code *>(codes);
+  const Decode dec;
+  const bool parallel = n * (size_t)cols >= kParallelGather;
+#pragma omp parallel for schedule(static) if (parallel)
+  for (long k = 0; k < (long)n; ++k) {
+    const Code *src = base + idx[k] * (size_t)cols;
+    float *d = dst + (size_t)k * cols;
+#pragma omp simd
+    for (int j = 0; j < cols; ++j)
+      d[j] = dec(src[j]) * scale[j] + offset[j];
+  }
+}
+
+}  
+
+CompactDataset::CompactDataset(DType dtype, int rows, int cols,
+                               std::vector<uint8_t> codes, Tensor y,
+                               std::vector<float> scale,
+                               std::vector<float> offset)
+    : dtype_(dtype), rows_(rows), cols_(cols), codes_(std::move(codes)),
+      scale_(std::move(scale)), offset_(std::move(offset)), y_(std::move(y)) {
+  CHECK(dtype_ == DType::U8 || dtype_ == DType::I16 || dtype_ == DType::F16,
+        "CompactDataset does not support dtype " << dtype_name(dtype_));
+  CHECK(codes_.size() == (size_t)rows_ * cols_ * dtype_size(dtype_),
+        "CompactDataset: expected " << (size_t)rows_ * cols_ << " "
+                                    << dtype_name(dtype_) << " codes, got "
+                                    << codes_.size() << " bytes");
+  CHECK(y_.rows == rows_, "CompactDataset mismatch rows");
+  if (scale_.empty())
+    scale_.assign(cols_, 1.0f);
+  if (offset_.empty())
+    offset_.assign(cols_, 0.0f);
+  CHECK((int)scale_.size() == cols_ && (int)offset_.size() == cols_,
+        "CompactDataset: scale/offset must have one entry per column");
+}
+
+CompactDataset CompactDataset::quantize(const Tensor &x, Tensor y,
+                                        DType dtype) {
+  const int rows = x.rows;
+  const int cols = x.cols;
+  std::vector<uint8_t> codes((size_t)rows * cols * dtype_size(dtype));
+  std::vector<float> scale(cols, 1.0f);
+  std::vector<float> offset(cols, 0.0f);
+
+  if (dtype == DType::F16) {
+    f32_to_f16(x.data.data(), reinterpret_cast<uint16_t *>(codes.data()),
+               x.size());
+    return CompactDataset(dtype, rows, cols, std::move(codes), std::move(y),
+                          std::move(scale), std::move(offset));
+  }
+  CHECK(dtype == DType::U8 || dtype == DType::I16,
+        "Cannot quantize to " << dtype_name(dtype));
+
+  std::vector<float> lo(cols, 0.0f), hi(cols, 0.0f);
+  if (rows > 0) {
+    std::copy(x.data.begin(), x.data.begin() + cols, lo.begin());
+    std::copy(x.data.begin(), x.data.begin() + cols, hi.begin());
+  }
+  for (int i = 0; i < rows; ++i)
+    for (int j = 0; j < cols; ++j) {
+      const float v = x.data[(size_t)i * cols + j];
+      lo[j] = std::min(lo[j], v);
+      hi[j] = std::max(hi[j], v);
+    }
+
+  const bool u8 = dtype == DType::U8;
+  const float levels = u8 ? 255.0f : 65535.0f;
+  const float qmin = u8 ? 0.0f : -32768.0f;
+  for (int j = 0; j < cols; ++j) {
+    if (rows == 0 || hi[j] <= lo[j]) {
+      scale[j] = 1.0f;
+      offset[j] = rows == 0 ? 0.0f : lo[j] - qmin;
+    } else {
+      scale[j] = (hi[j] - lo[j]) / levels;
+      offset[j] = lo[j] - qmin * scale[j];
+    }
+  }
+
+#pragma omp parallel for schedule(static) if ((size_t)rows * cols >= kParallelGather)
+  for (int i = 0; i < rows; ++i)
+    for (int j = 0; j < cols; ++j) {
+      const size_t at = (size_t)i * cols + j;
+      float q = std::floor((x.data[at] - offset[j]) / scale[j] + 0.5f);
+      q = std::min(std::max(q, qmin), qmin + levels);
+      if (u8)
+        codes[at] = (uint8_t)q;
+      else
+        reinterpret_cast<int16_t *>(codes.data())[at] = (int16_t)q;
+    }
+
+  return CompactDataset(dtype, rows, cols, std::move(codes), std::move(y),
+                        std::move(scale), std::move(offset));
+}
+
+size_t CompactDataset::feature_bytes() const {
+  return codes_.size() + (scale_.size() + offset_.size()) * sizeof(float);
+}
+
+void CompactDataset::decode_rows(const size_t *idx, size_t n,
+                                 float *dst) const {
+  const float *s = scale_.data();
+  const float *o = offset_.data();
+  switch (dtype_) {
+  case DType::U8:
+    decode<uint8_t, DecodeU8>(codes_.data(), cols_, s, o, idx, n, dst);
+    break;
+  case DType::I16:
+    decode<int16_t, DecodeI16>(codes_.data(), cols_, s, o, idx, n, dst);
+    break;
+  case DType::F16:
+    decode<uint16_t, DecodeF16>(codes_.data(), cols_, s, o, idx, n, dst);
+    break;
+  default:
+    THROW_ERROR("CompactDataset: bad dtype");
+  }
+}
+
+Sample CompactDataset::get(size_t i) const {
+  CHECK(i < (size_t)rows_, "Index out of bounds");
+  Sample s{Tensor(1, cols_), Tensor(1, y_.cols)};
+  decode_rows(&i, 1, s.x.data.data());
+  std::memcpy(s.y.data.data(), y_.data.data() + i * y_.cols,
+              (size_t)y_.cols * sizeof(float));
+  return s;
+}
+
+void CompactDataset::get_batch(const size_t *idx, size_t n, Tensor &x,
+                               Tensor &y) const {
+  for (size_t k = 0; k < n; ++k)
+    CHECK(idx[k] < (size_t)rows_, "Index out of bounds: " << idx[k]);
+  x.resize((int)n, cols_);
+  y.resize((int)n, y_.cols);
+  decode_rows(idx, n, x.data.data());
+  const int yc = y_.cols;
+  for (size_t k = 0; k < n; ++k)
+    std::memcpy(y.data.data() + k * yc, y_.data.data() + idx[k] * yc,
+                (size_t)yc * sizeof(float));
+}
+
+}  
@@ -0,0 +1,419 @@
+#include "data/csv.h"
+#include "core/error.h"
+#include "data/binary_dataset.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace tf {
+
+namespace {
+
+const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool is_digit(char c) { return (unsigned)(c - '0') < 10u; }
+
+inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+}  
+
+const char *parse_float(const char *p, const char *end, float &out) {
+  const char *start = p;
+  bool neg = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    neg = *p++ == '-';
+
+  // Up to 19 significant digits fit a uint64 exactly; later digits only
+  // shift the exponent.
+  uint64_t mant = 0;
+  int digits = 0;
+  int exp10 = 0;
+  bool any = false;
+  for (; p < end && is_digit(*p); ++p) {
+    any = true;
+    if (digits < 19) {
+      mant = mant * 10 + (uint64_t)(*p - '0');
+      if (mant)
+        ++digits;
+    } else {
+      ++exp10;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && is_digit(*p); ++p) {
+      any = true;
+      if (digits < 19) {
+        mant = mant * 10 + (uint64_t)(*p - '0');
+        if (mant)
+          ++digits;
+        --exp10;
+      }
+    }
+  }
+
+  if (!any) {
+    // inf / nan and anything else exotic go through the C library.
+    char buf[64];
+    const size_t n = std::min((size_t)(end - start), sizeof(buf) - 1);
+    std::memcpy(buf, start, n);
+    buf[n] = '\0';
+    char *stop = nullptr;
+    out = std::strtof(buf, &stop);
+    return stop == buf ? nullptr : start + (stop - buf);
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool eneg = false;
+    if (q < end && (*q == '-' || *q == '+'))
+      eneg = *q++ == '-';
+    if (q < end && is_digit(*q)) {
+      int e = 0;
+      for (; q < end && is_digit(*q); ++q)
+        if (e < 10000)
+          e = e * 10 + (*q - '0');
+      exp10 += eneg ? -e : e;
+      p = q;
+    }
+  }
+
+  double v = (double)mant;
+  if (mant == 0)
+    v = 0.0;
+  else if (exp10 >= 0 && exp10 <= 22)
+    v *= kPow10[exp10];
+  else if (exp10 < 0 && exp10 >= -22)
+    v /= kPow10[-exp10];
+  else
+    v *= std::pow(10.0, (double)exp10);
+  out = (float)(neg ? -v : v);
+  return p;
+}
+
+namespace {
+
+// Which output slot every CSV field maps to.
+struct Layout {
+  size_t num_fields = 0;
+  size_t label = 0;
+  std::vector<int> feature_slot; // per field: feature index or -1
+  int x_cols = 0;
+  int y_cols = 0;
+  int num_classes = 0;
+  char delimiter = ',';
+};
+
+struct Part {
+  std::vector<float> x;
+  std::vector<float> y;
+  size_t rows = 0;
+};
+
+std::vector<std::string> split_fields(const char *p, const char *end,
+                                      char delim) {
+  std::vector<std::string> out;
+  for (;;) {
+    const char *fe = static_cast<const char *>(std::memchr(p, delim, end - p));
+    if (!fe)
+      fe = end;
+    const char *a = p;
+    const char *b = fe;
+    while (a < b && is_space(*a))
+      ++a;
+    while (b > a && is_space(b[-1]))
+      --b;
+    out.emplace_back(a, b);
+    if (fe == end)
+      break;
+    p = fe + 1;
+  }
+  return out;
+}
+
+size_t find_column(const std::vector<std::string> &header,
+                   const std::string &name) {
+  auto it = std::find(header.begin(), header.end(), name);
+  CHECK(it != header.end(), "CSV has no column named '" << name << "'");
+  return (size_t)(it - header.begin());
+}
+
+Layout make_layout(const std::vector<std::string> &first,
+                   const CsvOptions &opts) {
+  Layout L;
+  L.num_fields = first.size();
+  L.delimiter = opts.delimiter;
+  L.num_classes = opts.num_classes;
+  CHECK(L.num_fields >= 2, "CSV needs at least a feature and a label column");
+
+  if (!opts.label_name.empty()) {
+    CHECK(opts.has_header, "label_name requires a header row");
+    L.label = find_column(first, opts.label_name);
+  } else {
+    const int lc = opts.label_column < 0 ? (int)L.num_fields - 1
+                                         : opts.label_column;
+    CHECK(lc >= 0 && (size_t)lc < L.num_fields,
+          "label_column " << opts.label_column << " out of range");
+    L.label = (size_t)lc;
+  }
+
+  std::vector<size_t> cols;
+  if (!opts.feature_names.empty()) {
+    CHECK(opts.has_header, "feature_names requires a header row");
+    for (const auto &n : opts.feature_names)
+      cols.push_back(find_column(first, n));
+  } else if (!opts.feature_columns.empty()) {
+    for (int c : opts.feature_columns) {
+      CHECK(c >= 0 && (size_t)c < L.num_fields,
+            "feature column " << c << " out of range");
+      cols.push_back((size_t)c);
+    }
+  } else {
+    for (size_t c = 0; c < L.num_fields; ++c)
+      if (c != L.label)
+        cols.push_back(c);
+  }
+
+  L.feature_slot.assign(L.num_fields, -1);
+  for (size_t i = 0; i < cols.size(); ++i) {
+    CHECK(cols[i] != L.label, "Column " << cols[i]
+                                        << " is both a feature and the label");
+    CHECK(L.feature_slot[cols[i]] < 0, "Column " << cols[i]
+                                                 << " selected twice");
+    L.feature_slot[cols[i]] = (int)i;
+  }
+  L.x_cols = (int)cols.size();
+  L.y_cols = opts.num_classes > 0 ? opts.num_classes : 1;
+  return L;
+}
+
+// Parses the complete lines in [p, end). base is the file offset of p, used
+// for error messages.
+void parse_lines(const char *p, const char *end, const Layout &L, size_t base,
+                 Part &out) {
+  const char *chunk = p;
+  const size_t xc = (size_t)L.x_cols;
+  const size_t yc = (size_t)L.y_cols;
+  while (p < end) {
+    const char *le = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (!le)
+      le = end;
+    const char *q = le;
+    while (q > p && is_space(q[-1]))
+      --q;
+    if (q == p) {
+      p = le + 1;
+      continue;
+    }
+
+    const size_t xo = out.x.size();
+    const size_t yo = out.y.size();
+    out.x.resize(xo + xc);
+    out.y.resize(yo + yc, 0.0f);
+    float *xr = out.x.data() + xo;
+    float *yr = out.y.data() + yo;
+
+    size_t field = 0;
+    const char *f = p;
+    for (;;) {
+      const char *fe =
+          static_cast<const char *>(std::memchr(f, L.delimiter, q - f));
+      if (!fe)
+        fe = q;
+      CHECK(field < L.num_fields, "Too many fields near byte "
+                                      << base + (f - chunk) << " (expected "
+                                      << L.num_fields << ")");
+      const int slot = L.feature_slot[field];
+      if (slot >= 0 || field == L.label) {
+        const char *a = f;
+        const char *b = fe;
+        while (a < b && is_space(*a))
+          ++a;
+        while (b > a && is_space(b[-1]))
+          --b;
+        float v = 0.0f;
+        const char *stop = a < b ? parse_float(a, b, v) : nullptr;
+        CHECK(stop == b, "Not a number: '" << std::string(a, b)
+                                           << "' near byte "
+                                           << base + (a - chunk));
+        if (slot >= 0) {
+          xr[slot] = v;
+        } else if (L.num_classes > 0) {
+          // Range-check before converting: (int)v is undefined for NaN,
+          // infinities and values like 1e20.
+          const bool in_range = v >= 0.0f && v < (float)L.num_classes;
+          const int cls = in_range ? (int)v : -1;
+          CHECK(in_range && (float)cls == v,
+                "Invalid class label '" << std::string(a, b) << "' near byte "
+                                        << base + (a - chunk));
+          yr[cls] = 1.0f;
+        } else {
+          yr[0] = v;
+        }
+      }
+      ++field;
+      if (fe == q)
+        break;
+      f = fe + 1;
+    }
+    CHECK(field == L.num_fields, "Expected " << L.num_fields
+                                             << " fields, got " << field
+                                             << " near byte "
+                                             << base + (p - chunk));
+    ++out.rows;
+    p = le + 1;
+  }
+}
+
+using LayoutFn = std::function<void(const Layout &)>;
+using PartFn = std::function<void(const Part &)>;
+
+// Reads the file chunk by chunk, splits each chunk at line boundaries into
+// one range per thread and hands the parsed parts to on_part in file order.
+void scan_csv(const std::string &path, const CsvOptions &opts,
+              const LayoutFn &on_layout, const PartFn &on_part) {
+  std::ifstream in(path, std::ios::binary);
+  CHECK(in.is_open(), "Could not open CSV file: " << path);
+  CHECK(opts.chunk_bytes > 0, "chunk_bytes must be positive");
+
+  size_t threads = opts.num_threads;
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector<char> buf;
+  size_t filled = 0;      // valid bytes in buf
+  size_t file_offset = 0; // file offset of buf[0]
+  bool eof = false;
+  bool have_layout = false;
+  Layout layout;
+  std::vector<Part> parts(threads);
+
+  for (;;) {
+    // Top up to a chunk plus whatever partial line was carried over.
+    if (!eof) {
+      buf.resize(std::max(buf.size(), filled + opts.chunk_bytes));
+      in.read(buf.data() + filled, (std::streamsize)(buf.size() - filled));
+      filled += (size_t)in.gcount();
+      eof = !in;
+    }
+    if (filled == 0)
+      break;
+
+    size_t usable = filled;
+    if (!eof) {
+      const char *last = nullptr;
+      for (size_t i = filled; i > 0; --i)
+        if (buf[i - 1] == '\n') {
+          last = buf.data() + i;
+          break;
+        }
+      if (!last) {
+        // A single line longer than the buffer: grow and keep reading.
+        buf.resize(buf.size() * 2);
+        continue;
+      }
+      usable = (size_t)(last - buf.data());
+    }
+
+    const char *begin = buf.data();
+    const char *end = begin + usable;
+
+    if (!have_layout) {
+      // The first line fixes the column count (and names, with a header).
+      const char *le =
+          static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+      const char *line_end = le ? le : end;
+      layout = make_layout(split_fields(begin, line_end, opts.delimiter),
+                           opts);
+      have_layout = true;
+      on_layout(layout);
+      if (opts.has_header)
+        begin = le ? le + 1 : end;
+    }
+
+    // Split at newlines into roughly equal ranges.
+    std::vector<const char *> cuts(threads + 1, end);
+    cuts[0] = begin;
+    const size_t span = (size_t)(end - begin);
+    for (size_t t = 1; t < threads; ++t) {
+      const char *c = std::max(cuts[t - 1], begin + span * t / threads);
+      const char *nl =
+          c < end ? static_cast<const char *>(std::memchr(c, '\n', end - c))
+                  : nullptr;
+      cuts[t] = nl ? nl + 1 : end;
+    }
+
+    std::vector<std::exception_ptr> errors(threads);
+#pragma omp parallel for schedule(static, 1) num_threads((int)threads)
+    for (long t = 0; t < (long)threads; ++t) {
+      Part &part = parts[t];
+      part.x.clear();
+      part.y.clear();
+      part.rows = 0;
+      try {
+        parse_lines(cuts[t], cuts[t + 1], layout,
+                    file_offset + (size_t)(cuts[t] - buf.data()), part);
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    }
+    for (auto &e : errors)
+      if (e)
+        std::rethrow_exception(e);
+    for (const auto &part : parts)
+      if (part.rows > 0)
+        on_part(part);
+
+    if (eof)
+      break;
+    std::memmove(buf.data(), buf.data() + usable, filled - usable);
+    filled -= usable;
+    file_offset += usable;
+  }
+
+  CHECK(have_layout, "CSV file is empty: " << path);
+}
+
+}  
+
+TensorDataset read_csv(const std::string &path, const CsvOptions &opts) {
+  Layout layout;
+  std::vector<float> xs, ys;
+  scan_csv(
+      path, opts, [&](const Layout &l) { layout = l; },
+      [&](const Part &p) {
+        xs.insert(xs.end(), p.x.begin(), p.x.end());
+        ys.insert(ys.end(), p.y.begin(), p.y.end());
+      });
+
+  const int rows = layout.x_cols > 0 ? (int)(xs.size() / layout.x_cols) : 0;
+  Tensor x(rows, layout.x_cols);
+  Tensor y(rows, layout.y_cols);
+  std::copy(xs.begin(), xs.end(), x.data.begin());
+  std::copy(ys.begin(), ys.end(), y.data.begin());
+  return TensorDataset(std::move(x), std::move(y));
+}
+
+size_t csv_to_binary(const std::string &csv_path, const std::string &out_path,
+                     const CsvOptions &opts, DType x_dtype, float x_scale,
+                     float x_bias) {
+  std::unique_ptr<BinaryDatasetWriter> writer;
+  scan_csv(
+      csv_path, opts,
+      [&](const Layout &l) {
+        writer.reset(new BinaryDatasetWriter(out_path, l.x_cols, l.y_cols,
+                                             x_dtype, x_scale, x_bias));
+      },
+      [&](const Part &p) { writer->append(p.x.data(), p.y.data(), p.rows); });
+  writer->finish();
+  return writer->rows();
+}
+
+}  
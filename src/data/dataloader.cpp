@@ -1,79 +1,311 @@
 #include "data/dataloader.h"
+#include "io/training_state.h"
 #include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <utility>
 
 namespace tf {
 
 DataLoader::DataLoader(Dataset &dataset, size_t batch_size, bool shuffle,
                        uint64_t seed)
-    : dataset_(dataset), batch_size_(batch_size), shuffle_(shuffle),
-      rng_((unsigned int)seed), current_idx_(0) {
+    : DataLoader(dataset, batch_size, [&] {
+        LoaderOptions o;
+        o.shuffle = shuffle;
+        o.seed = seed;
+        return o;
+      }()) {}
+
+DataLoader::DataLoader(Dataset &dataset, size_t batch_size,
+                       const LoaderOptions &opts)
+    : dataset_(dataset), batch_size_(batch_size), shuffle_(opts.shuffle),
+      rng_(opts.seed), current_idx_(0),
+      shuffle_block_(opts.shuffle_block),
+      shuffle_window_(std::max<size_t>(opts.shuffle_window, 1)) {
+  CHECK(batch_size_ > 0, "DataLoader batch_size must be positive");
   indices_.resize(dataset_.size());
   std::iota(indices_.begin(), indices_.end(), 0);
+  num_batches_ = len();
+  if (opts.prefetch > 0 || opts.num_workers > 1)
+    slots_.resize(std::max(opts.prefetch, opts.num_workers));
   reset();
+  if (!slots_.empty())
+    start_workers(std::max<size_t>(opts.num_workers, 1));
 }
 
+DataLoader::~DataLoader() { stop_workers(); }
+
 size_t DataLoader::len() const {
   return (dataset_.size() + batch_size_ - 1) / batch_size_;
 }
 
 size_t DataLoader::size() const { return dataset_.size(); }
 
+void DataLoader::shuffle_indices() {
+  if (shuffle_block_ > 0) {
+    block_shuffle_indices();
+    return;
+  }
+  if (indices_.size() < 2)
+    return;
+  for (size_t i = indices_.size() - 1; i > 0; --i) {
+    size_t j = (size_t)rng_.uniform_int64(i + 1);
+    std::swap(indices_[i], indices_[j]);
+  }
+}
+
+void DataLoader::block_shuffle_indices() {
+  const size_t n = indices_.size();
+  const size_t num_blocks = (n + shuffle_block_ - 1) / shuffle_block_;
+  block_order_.resize(num_blocks);
+  std::iota(block_order_.begin(), block_order_.end(), 0);
+  for (size_t i = num_blocks; i > 1; --i) {
+    size_t j = (size_t)rng_.uniform_int64(i);
+    std::swap(block_order_[i - 1], block_order_[j]);
+  }
+
+  window_begin_.clear();
+  size_t pos = 0;
+  for (size_t b = 0; b < num_blocks; b += shuffle_window_) {
+    const size_t start = pos;
+    window_begin_.push_back(start);
+    const size_t last = std::min(b + shuffle_window_, num_blocks);
+    for (size_t k = b; k < last; ++k) {
+      const size_t row = block_order_[k] * shuffle_block_;
+      const size_t rows = std::min(shuffle_block_, n - row);
+      for (size_t r = 0; r < rows; ++r)
+        indices_[pos++] = row + r;
+    }
+    for (size_t i = pos - start; i > 1; --i) {
+      size_t j = (size_t)rng_.uniform_int64(i);
+      std::swap(indices_[start + i - 1], indices_[start + j]);
+    }
+  }
+  window_begin_.push_back(n);
+}
+
+// Tells the dataset which blocks the window after each window starting in
+// [begin, end) will read, so they are fetched while the current one is
+// consumed. Window 0 is hinted by the batch at position 0.
+void DataLoader::hint_windows(size_t begin, size_t end) const {
+  if (window_begin_.size() < 2)
+    return;
+  const size_t num_windows = window_begin_.size() - 1;
+  auto it = std::lower_bound(window_begin_.begin(), window_begin_.end() - 1,
+                             begin);
+  for (; it != window_begin_.end() - 1 && *it < end; ++it) {
+    const size_t w = (size_t)(it - window_begin_.begin());
+    for (size_t ahead = w == 0 ? 0 : 1; ahead <= 1; ++ahead) {
+      const size_t hw = w + ahead;
+      if (hw >= num_windows)
+        break;
+      const size_t first = hw * shuffle_window_;
+      const size_t last = std::min(first + shuffle_window_, block_order_.size());
+      for (size_t k = first; k < last; ++k) {
+        const size_t row = block_order_[k] * shuffle_block_;
+        dataset_.will_need(row, std::min(shuffle_block_, indices_.size() - row));
+      }
+    }
+  }
+}
+
 void DataLoader::reset() {
+  if (slots_.empty()) {
+    current_idx_ = 0;
+    if (shuffle_)
+      shuffle_indices();
+    return;
+  }
+
+  // Workers read indices_ while assembling, so wait for in-flight batches
+  // before reshuffling. Nothing new is claimed meanwhile because the lock
+  // is held from here until the new epoch is published.
+  std::unique_lock<std::mutex> lock(mu_);
+  next_claim_ = num_batches_;
+  ready_cv_.wait(lock, [&] { return in_flight_ == 0; });
   current_idx_ = 0;
-  if (shuffle_) {
-    
-    for (size_t i = indices_.size() - 1; i > 0; --i) {
-      size_t j = rng_.next_u32() % (i + 1);
-      std::swap(indices_[i], indices_[j]);
+  if (shuffle_)
+    shuffle_indices();
+  for (auto &s : slots_) {
+    s.ready = false;
+    s.error = nullptr;
+  }
+  next_claim_ = 0;
+  consumed_ = 0;
+  lock.unlock();
+  work_cv_.notify_all();
+}
+
+void DataLoader::fill(size_t batch, Tensor &x, Tensor &y) const {
+  const size_t begin = batch * batch_size_;
+  const size_t end = std::min(begin + batch_size_, indices_.size());
+  hint_windows(begin, end);
+  dataset_.get_batch(indices_.data() + begin, end - begin, x, y);
+}
+
+void DataLoader::start_workers(size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    workers_.emplace_back([this] { worker_loop(); });
+}
+
+void DataLoader::stop_workers() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto &t : workers_)
+    t.join();
+  workers_.clear();
+}
+
+void DataLoader::worker_loop() {
+  const size_t ring = slots_.size();
+  std::unique_lock<std::mutex> lock(mu_);
+  for (;;) {
+    work_cv_.wait(lock, [&] {
+      return stop_ ||
+             (next_claim_ < num_batches_ && next_claim_ < consumed_ + ring);
+    });
+    if (stop_)
+      return;
+
+    const size_t b = next_claim_++;
+    Slot &slot = slots_[b % ring];
+    ++in_flight_;
+    lock.unlock();
+
+    std::exception_ptr error;
+    try {
+      fill(b, slot.x, slot.y);
+    } catch (...) {
+      error = std::current_exception();
     }
+
+    lock.lock();
+    slot.batch = b;
+    slot.error = error;
+    slot.ready = true;
+    --in_flight_;
+    ready_cv_.notify_all();
   }
 }
 
 bool DataLoader::next(Tensor &batch_x, Tensor &batch_y) {
-  if (current_idx_ >= indices_.size())
-    return false;
+  if (slots_.empty()) {
+    if (current_idx_ >= indices_.size())
+      return false;
 
-  size_t end_idx = std::min(current_idx_ + batch_size_, indices_.size());
-  size_t actual_batch_size = end_idx - current_idx_;
+    size_t end_idx = std::min(current_idx_ + batch_size_, indices_.size());
+    hint_windows(current_idx_, end_idx);
+    dataset_.get_batch(indices_.data() + current_idx_,
+                       end_idx - current_idx_, batch_x, batch_y);
+    current_idx_ = end_idx;
+    ++stats_.batches;
+    return true;
+  }
 
-  if (actual_batch_size == 0)
+  std::unique_lock<std::mutex> lock(mu_);
+  if (consumed_ >= num_batches_)
     return false;
 
-  Sample first = dataset_.get(indices_[current_idx_]);
+  Slot &slot = slots_[consumed_ % slots_.size()];
+  if (!slot.ready) {
+    const auto t0 = std::chrono::steady_clock::now();
+    ready_cv_.wait(lock, [&] { return slot.ready; });
+    ++stats_.stalls;
+    stats_.stall_seconds += std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - t0)
+                                .count();
+  }
 
-  batch_x = Tensor((int)actual_batch_size, first.x.cols);
-  batch_y = Tensor((int)actual_batch_size, first.y.cols);
+  if (slot.error) {
+    std::exception_ptr error = slot.error;
+    slot.error = nullptr;
+    slot.ready = false;
+    ++consumed_;
+    lock.unlock();
+    work_cv_.notify_all();
+    std::rethrow_exception(error);
+  }
 
-  {
-    float *bx_ptr = batch_x.data.data();
-    const float *s_x = first.x.data.data();
-    for (size_t k = 0; k < first.x.size(); ++k)
-      bx_ptr[k] = s_x[k];
+  std::swap(batch_x, slot.x);
+  std::swap(batch_y, slot.y);
+  slot.ready = false;
+  ++consumed_;
+  current_idx_ = std::min(consumed_ * batch_size_, indices_.size());
+  ++stats_.batches;
+  lock.unlock();
+  work_cv_.notify_all();
+  return true;
+}
 
-    float *by_ptr = batch_y.data.data();
-    const float *s_y = first.y.data.data();
-    for (size_t k = 0; k < first.y.size(); ++k)
-      by_ptr[k] = s_y[k];
+void DataLoader::export_state(TrainingState &out,
+                              const std::string &prefix) const {
+  out.put_value(prefix + "batch_size", (uint64_t)batch_size_);
+  out.put_value(prefix + "dataset_size", (uint64_t)indices_.size());
+  out.put_value(prefix + "shuffle", (uint8_t)shuffle_);
+  out.put_value(prefix + "shuffle_block", (uint64_t)shuffle_block_);
+  out.put_value(prefix + "shuffle_window", (uint64_t)shuffle_window_);
+  out.put_value(prefix + "position", (uint64_t)current_idx_);
+  out.put_value(prefix + "rng", rng_);
+  out.put_bytes(prefix + "indices", indices_.data(),
+                indices_.size() * sizeof(size_t));
+  if (shuffle_block_ > 0) {
+    out.put_bytes(prefix + "block_order", block_order_.data(),
+                  block_order_.size() * sizeof(size_t));
+    out.put_bytes(prefix + "window_begin", window_begin_.data(),
+                  window_begin_.size() * sizeof(size_t));
   }
+}
 
-  for (size_t k = 1; k < actual_batch_size; ++k) {
-    size_t data_idx = indices_[current_idx_ + k];
-    Sample s = dataset_.get(data_idx);
+void DataLoader::import_state(const TrainingState &in,
+                              const std::string &prefix) {
+  CHECK(in.value<uint64_t>(prefix + "batch_size") == batch_size_,
+        "Loader state was saved with a different batch size");
+  CHECK(in.value<uint64_t>(prefix + "dataset_size") == indices_.size() &&
+            in.bytes(prefix + "indices") == indices_.size() * sizeof(size_t),
+        "Loader state was saved for a dataset of a different size");
+  CHECK(in.value<uint8_t>(prefix + "shuffle") == (uint8_t)shuffle_,
+        "Loader state was saved with a different shuffle setting");
+  CHECK(in.value<uint64_t>(prefix + "shuffle_block") == shuffle_block_ &&
+            (shuffle_block_ == 0 ||
+             in.value<uint64_t>(prefix + "shuffle_window") == shuffle_window_),
+        "Loader state was saved with different block-shuffle options");
 
-    float *bx_ptr = batch_x.data.data() + k * batch_x.cols;
-    const float *s_x = s.x.data.data();
-    for (int j = 0; j < batch_x.cols; ++j)
-      bx_ptr[j] = s_x[j];
+  // Same protocol as reset(): no batch may be in flight while indices_
+  // changes underneath the workers.
+  std::unique_lock<std::mutex> lock(mu_, std::defer_lock);
+  if (!slots_.empty()) {
+    lock.lock();
+    next_claim_ = num_batches_;
+    ready_cv_.wait(lock, [&] { return in_flight_ == 0; });
+  }
 
-    float *by_ptr = batch_y.data.data() + k * batch_y.cols;
-    const float *s_y = s.y.data.data();
-    for (int j = 0; j < batch_y.cols; ++j)
-      by_ptr[j] = s_y[j];
+  rng_ = in.value<RNG>(prefix + "rng");
+  in.get_bytes(prefix + "indices", indices_.data(),
+               indices_.size() * sizeof(size_t));
+  current_idx_ = std::min<size_t>(in.value<uint64_t>(prefix + "position"),
+                                  indices_.size());
+  if (shuffle_block_ > 0) {
+    block_order_.resize(in.bytes(prefix + "block_order") / sizeof(size_t));
+    in.get_bytes(prefix + "block_order", block_order_.data(),
+                 block_order_.size() * sizeof(size_t));
+    window_begin_.resize(in.bytes(prefix + "window_begin") / sizeof(size_t));
+    in.get_bytes(prefix + "window_begin", window_begin_.data(),
+                 window_begin_.size() * sizeof(size_t));
   }
 
-  current_idx_ = end_idx;
-  return true;
+  if (!slots_.empty()) {
+    for (auto &s : slots_) {
+      s.ready = false;
+      s.error = nullptr;
+    }
+    consumed_ = (current_idx_ + batch_size_ - 1) / batch_size_;
+    next_claim_ = consumed_;
+    lock.unlock();
+    work_cv_.notify_all();
+  }
 }
 
 }  
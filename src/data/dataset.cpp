@@ -0,0 +1,58 @@
+#include "data/dataset.h"
+#include <cstring>
+
+namespace tf {
+
+namespace {
+
+// Below this many gathered floats a batch is copied on the calling thread.
+constexpr size_t kParallelGather = 1 << 15;
+
+void copy_row(float *dst, const float *src, int cols) {
+  std::memcpy(dst, src, (size_t)cols * sizeof(float));
+}
+
+}  
+
+void Dataset::get_batch(const size_t *idx, size_t n, Tensor &x,
+                        Tensor &y) const {
+  CHECK(n > 0, "get_batch with empty index list");
+  Sample first = get(idx[0]);
+  x.resize((int)n, first.x.cols);
+  y.resize((int)n, first.y.cols);
+  copy_row(x.data.data(), first.x.data.data(), x.cols);
+  copy_row(y.data.data(), first.y.data.data(), y.cols);
+  for (size_t k = 1; k < n; ++k) {
+    Sample s = get(idx[k]);
+    CHECK(s.x.cols == x.cols && s.y.cols == y.cols,
+          "Inconsistent sample shape at index " << idx[k]);
+    copy_row(x.data.data() + k * x.cols, s.x.data.data(), x.cols);
+    copy_row(y.data.data() + k * y.cols, s.y.data.data(), y.cols);
+  }
+}
+
+void TensorDataset::get_batch(const size_t *idx, size_t n, Tensor &x,
+                              Tensor &y) const {
+  const size_t rows = (size_t)x_.rows;
+  for (size_t k = 0; k < n; ++k)
+    CHECK(idx[k] < rows, "Index out of bounds: " << idx[k]);
+
+  x.resize((int)n, x_.cols);
+  y.resize((int)n, y_.cols);
+
+  const int xc = x_.cols;
+  const int yc = y_.cols;
+  const float *xs = x_.data.data();
+  const float *ys = y_.data.data();
+  float *xd = x.data.data();
+  float *yd = y.data.data();
+  const bool parallel = n * (size_t)(xc + yc) >= kParallelGather;
+
+#pragma omp parallel for schedule(static) if (parallel)
+  for (long k = 0; k < (long)n; ++k) {
+    copy_row(xd + (size_t)k * xc, xs + idx[k] * xc, xc);
+    copy_row(yd + (size_t)k * yc, ys + idx[k] * yc, yc);
+  }
+}
+
+}  
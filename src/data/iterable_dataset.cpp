@@ -0,0 +1,151 @@
+#include "data/iterable_dataset.h"
+#include "core/error.h"
+#include "data/csv.h"
+#include <algorithm>
+#include <cstring>
+
+namespace tf {
+
+size_t GeneratorDataset::read(float *x, float *y, size_t max_rows) {
+  size_t n = 0;
+  while (!done_ && n < max_rows) {
+    if (!fn_(x + n * x_cols_, y + n * y_cols_)) {
+      done_ = true;
+      break;
+    }
+    ++n;
+  }
+  return n;
+}
+
+TextStreamDataset::TextStreamDataset(std::istream &in, int features,
+                                     int num_classes, char delimiter)
+    : in_(in), features_(features), num_classes_(num_classes),
+      delimiter_(delimiter) {
+  CHECK(features_ > 0, "TextStreamDataset needs at least one feature");
+}
+
+size_t TextStreamDataset::read(float *x, float *y, size_t max_rows) {
+  const int yc = target_cols();
+  size_t n = 0;
+  while (n < max_rows && std::getline(in_, line_)) {
+    ++lines_;
+    const char *p = line_.data();
+    const char *end = p + line_.size();
+    while (end > p && (end[-1] == '\r' || end[-1] == ' '))
+      --end;
+    if (p == end)
+      continue;
+
+    float *xr = x + n * features_;
+    float *yr = y + n * yc;
+    for (int f = 0; f <= features_; ++f) {
+      while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+      float v = 0.0f;
+      const char *stop = parse_float(p, end, v);
+      CHECK(stop, "Line " << lines_ << ": expected a number at column " << f);
+      if (f < features_) {
+        xr[f] = v;
+      } else if (num_classes_ > 0) {
+        // Range-check before converting, as (int)v is undefined for
+        // non-finite or huge values.
+        const bool in_range = v >= 0.0f && v < (float)num_classes_;
+        const int cls = in_range ? (int)v : -1;
+        CHECK(in_range && (float)cls == v,
+              "Line " << lines_ << ": invalid class label " << v);
+        std::fill(yr, yr + yc, 0.0f);
+        yr[cls] = 1.0f;
+      } else {
+        yr[0] = v;
+      }
+      p = stop;
+      while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+      if (f < features_) {
+        CHECK(p < end && *p == delimiter_,
+              "Line " << lines_ << ": expected " << features_ + 1
+                      << " fields");
+        ++p;
+      }
+    }
+    CHECK(p == end, "Line " << lines_ << ": trailing data");
+    ++n;
+  }
+  return n;
+}
+
+StreamLoader::StreamLoader(IterableDataset &source, size_t batch_size,
+                           const StreamOptions &opts)
+    : src_(source), batch_size_(batch_size),
+      capacity_(std::max<size_t>(opts.shuffle_buffer, 1)),
+      chunk_rows_(std::max<size_t>(opts.chunk_rows, 1)),
+      xc_(source.feature_cols()), yc_(source.target_cols()), rng_(opts.seed) {
+  CHECK(batch_size_ > 0, "StreamLoader batch_size must be positive");
+  buf_x_.resize(capacity_ * xc_);
+  buf_y_.resize(capacity_ * yc_);
+  chunk_x_.resize(chunk_rows_ * xc_);
+  chunk_y_.resize(chunk_rows_ * yc_);
+}
+
+void StreamLoader::refill_chunk() {
+  chunk_pos_ = 0;
+  chunk_len_ = eof_ ? 0 : src_.read(chunk_x_.data(), chunk_y_.data(),
+                                    chunk_rows_);
+  if (chunk_len_ == 0)
+    eof_ = true;
+}
+
+// Moves the next incoming row into buffer slot `slot`; false at the end of
+// the stream.
+bool StreamLoader::pull_row(size_t slot) {
+  if (chunk_pos_ == chunk_len_) {
+    refill_chunk();
+    if (chunk_len_ == 0)
+      return false;
+  }
+  std::memcpy(buf_x_.data() + slot * xc_, chunk_x_.data() + chunk_pos_ * xc_,
+              xc_ * sizeof(float));
+  std::memcpy(buf_y_.data() + slot * yc_, chunk_y_.data() + chunk_pos_ * yc_,
+              yc_ * sizeof(float));
+  ++chunk_pos_;
+  return true;
+}
+
+bool StreamLoader::next(Tensor &batch_x, Tensor &batch_y) {
+  while (count_ < capacity_ && pull_row(count_))
+    ++count_;
+  if (count_ == 0)
+    return false;
+
+  const size_t n = batch_size_;
+  batch_x.resize((int)n, xc_);
+  batch_y.resize((int)n, yc_);
+
+  size_t k = 0;
+  for (; k < n && count_ > 0; ++k) {
+    const size_t j = rng_.uniform_int((uint32_t)count_);
+    std::memcpy(batch_x.data.data() + k * xc_, buf_x_.data() + j * xc_,
+                xc_ * sizeof(float));
+    std::memcpy(batch_y.data.data() + k * yc_, buf_y_.data() + j * yc_,
+                yc_ * sizeof(float));
+    if (!pull_row(j)) {
+      // Stream over: close the gap with the last buffered row.
+      --count_;
+      if (j != count_) {
+        std::memcpy(buf_x_.data() + j * xc_, buf_x_.data() + count_ * xc_,
+                    xc_ * sizeof(float));
+        std::memcpy(buf_y_.data() + j * yc_, buf_y_.data() + count_ * yc_,
+                    yc_ * sizeof(float));
+      }
+    }
+  }
+  if (k < n) {
+    batch_x.resize((int)k, xc_);
+    batch_y.resize((int)k, yc_);
+  }
+  emitted_ += k;
+  return true;
+}
+
+}  
@@ -5,42 +5,36 @@
 
 namespace tf {
 
-static float randn(RNG &rng) {
-  float u1 = rng.uniform01();
-  float u2 = rng.uniform01();
-  if (u1 < 1e-6f)
-    u1 = 1e-6f;
-  return std::sqrt(-2.0f * std::log(u1)) * std::cos(2.0f * 3.14159265f * u2);
-}
-
 TensorDataset make_blobs(int samples, int features, int centers,
                          float cluster_std, int seed) {
-  RNG rng((unsigned int)seed);
+  RNG rng((uint64_t)seed);
 
   
   Tensor center_locs(centers, features);
-  for (size_t i = 0; i < center_locs.size(); ++i) {
-    center_locs.data[i] = rng.uniform(-10.0f, 10.0f);
-  }
+  rng.fill_uniform(center_locs.data.data(), center_locs.size(), -10.0f, 10.0f);
+
+  // All randomness is drawn in bulk up front; the counter-based generator
+  // makes that independent of thread count, so rows can be built in
+  // parallel.
+  std::vector<float> pick(samples);
+  rng.fill_uniform(pick.data(), pick.size());
 
   Tensor X(samples, features);
   Tensor Y(samples, centers);
-  Y.fill_(0.0f); 
+  rng.fill_normal(X.data.data(), X.size(), 0.0f, cluster_std);
 
+#pragma omp parallel for schedule(static) if ((size_t)samples * features >= (1 << 16))
   for (int i = 0; i < samples; ++i) {
     
-    int c = (int)(rng.uniform01() * centers);
+    int c = (int)(pick[i] * centers);
     if (c >= centers)
       c = centers - 1;
 
     Y(i, c) = 1.0f;
 
     
-    for (int j = 0; j < features; ++j) {
-      float center_val = center_locs(c, j);
-      float noise = randn(rng) * cluster_std;
-      X(i, j) = center_val + noise;
-    }
+    for (int j = 0; j < features; ++j)
+      X(i, j) += center_locs(c, j);
   }
 
   return TensorDataset(std::move(X), std::move(Y));
@@ -1,17 +1,76 @@
 #include "io/checkpoint.h"
 #include "core/error.h"
+#include "io/crc32c.h"
+#include "io/delta_checkpoint.h"
 #include "nn/module.h"
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define TF_HAVE_POSIX_IO 1
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace tf {
 
 static const char MAGIC[] = "TNN1";
 static const uint32_t VERSION = 1;
 
-void save_checkpoint(const Module &model, const std::string &path) {
+static const char MAGIC_V2[] = "TNN2";
+static const uint32_t VERSION_V2 = 2;
+
+// A V2 file image being assembled in memory.
+struct StagedCheckpoint {
+  std::vector<CheckpointEntry> entries;
+  std::vector<uint8_t> bytes;
+  uint64_t index_bytes = 0;
+  uint64_t data_offset = 0;
+};
+
+namespace {
+
+struct V2Header {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_tensors;
+  uint32_t index_crc;
+  uint64_t index_offset;
+  uint64_t index_bytes;
+  uint64_t data_offset;
+  uint64_t file_bytes;
+  uint8_t reserved[16];
+};
+static_assert(sizeof(V2Header) == 64, "header must be 64 bytes");
+
+// Copies are split into pieces of this many bytes across threads.
+constexpr size_t kCopyChunk = 1 << 20;
+
+uint64_t align_up(uint64_t v, uint64_t a) { return (v + a - 1) / a * a; }
+
+template <typename T> void put(std::vector<char> &buf, const T &v) {
+  const char *p = reinterpret_cast<const char *>(&v);
+  buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+template <typename T> T take(const uint8_t *&p, const uint8_t *end) {
+  CHECK(p + sizeof(T) <= end, "Corrupt checkpoint index (truncated)");
+  T v;
+  std::memcpy(&v, p, sizeof(T));
+  p += sizeof(T);
+  return v;
+}
+
+void save_v1(const Module &model, const std::string &path) {
   std::ofstream out(path, std::ios::binary);
   CHECK(out.is_open(), "Could not open file for writing: " << path);
 
@@ -37,7 +96,168 @@ void save_checkpoint(const Module &model, const std::string &path) {
   }
 }
 
-void load_checkpoint(Module &model, const std::string &path) {
+// Computes the V2 layout for `sources` and copies their data into
+// `s.bytes` at their final file offsets. This is the only part of a save
+// that has to run while the sources are quiescent.
+void stage_v2(const std::vector<CheckpointSource> &sources,
+              StagedCheckpoint &s) {
+  const size_t n = sources.size();
+
+  s.entries.resize(n);
+  size_t index_bytes = 0;
+  for (size_t i = 0; i < n; ++i) {
+    CheckpointEntry &e = s.entries[i];
+    e.name = sources[i].name;
+    e.dtype = sources[i].dtype;
+    e.rows = sources[i].rows;
+    e.cols = sources[i].cols;
+    CHECK(e.rows >= 0 && e.cols >= 0,
+          "Negative shape for checkpoint entry '" << e.name << "'");
+    e.nbytes = (uint64_t)e.rows * e.cols * dtype_size(e.dtype);
+    index_bytes += 4 + e.name.size() + 4 + 4 + 4 + 8 + 8 + 4;
+  }
+  s.index_bytes = index_bytes;
+
+  uint64_t at = align_up(sizeof(V2Header) + index_bytes,
+                         CheckpointReader::kAlign);
+  s.data_offset = at;
+  for (auto &e : s.entries) {
+    e.offset = at;
+    at = align_up(at + e.nbytes, CheckpointReader::kAlign);
+  }
+  // resize() never shrinks capacity, so a reused buffer is not reallocated.
+  s.bytes.resize(at);
+
+  uint8_t *base = s.bytes.data();
+  uint64_t pos = s.data_offset;
+  for (const auto &e : s.entries) {
+    std::memset(base + pos, 0, e.offset - pos);
+    pos = e.offset + e.nbytes;
+  }
+  std::memset(base + pos, 0, at - pos);
+
+  struct Piece {
+    const uint8_t *src;
+    uint8_t *dst;
+    size_t bytes;
+  };
+  std::vector<Piece> pieces;
+  for (size_t i = 0; i < n; ++i) {
+    const uint8_t *src = static_cast<const uint8_t *>(sources[i].data);
+    uint8_t *dst = base + s.entries[i].offset;
+    for (size_t off = 0; off < s.entries[i].nbytes; off += kCopyChunk)
+      pieces.push_back(
+          {src + off, dst + off,
+           std::min(kCopyChunk, (size_t)s.entries[i].nbytes - off)});
+  }
+#pragma omp parallel for schedule(dynamic) if (pieces.size() > 1)
+  for (long i = 0; i < (long)pieces.size(); ++i)
+    std::memcpy(pieces[i].dst, pieces[i].src, pieces[i].bytes);
+}
+
+// Checksums the staged payloads and encodes the header and index in front
+// of them.
+void finalize_v2(StagedCheckpoint &s) {
+  uint8_t *base = s.bytes.data();
+  const long n = (long)s.entries.size();
+#pragma omp parallel for schedule(dynamic)
+  for (long i = 0; i < n; ++i)
+    s.entries[i].crc = crc32c(base + s.entries[i].offset, s.entries[i].nbytes);
+
+  std::vector<char> index;
+  index.reserve(s.index_bytes);
+  for (const auto &e : s.entries) {
+    put(index, (uint32_t)e.name.size());
+    index.insert(index.end(), e.name.begin(), e.name.end());
+    put(index, (uint32_t)e.dtype);
+    put(index, (int32_t)e.rows);
+    put(index, (int32_t)e.cols);
+    put(index, e.offset);
+    put(index, e.nbytes);
+    put(index, e.crc);
+  }
+
+  V2Header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, MAGIC_V2, 4);
+  h.version = VERSION_V2;
+  h.num_tensors = (uint32_t)n;
+  h.index_offset = sizeof(V2Header);
+  h.index_bytes = index.size();
+  h.data_offset = s.data_offset;
+  h.file_bytes = s.bytes.size();
+  h.index_crc = crc32c(index.data(), index.size());
+
+  std::memcpy(base, &h, sizeof(h));
+  std::memcpy(base + sizeof(h), index.data(), index.size());
+  std::memset(base + sizeof(h) + index.size(), 0,
+              s.data_offset - sizeof(h) - index.size());
+}
+
+// Writes `n` bytes to `path.tmp`, flushes them to stable storage and
+// renames the result over `path`.
+void write_atomic(const std::string &path, const uint8_t *data, size_t n) {
+  const std::string tmp = path + ".tmp";
+#ifdef TF_HAVE_POSIX_IO
+  int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  CHECK(fd >= 0, "Could not open file for writing: " << tmp);
+  size_t done = 0;
+  while (done < n) {
+    ssize_t w = ::write(fd, data + done, n - done);
+    if (w < 0 && errno == EINTR)
+      continue;
+    if (w <= 0) {
+      ::close(fd);
+      THROW_ERROR("Failed to write checkpoint " << tmp << ": "
+                                                << std::strerror(errno));
+    }
+    done += (size_t)w;
+  }
+  const bool synced = ::fsync(fd) == 0;
+  ::close(fd);
+  CHECK(synced, "fsync failed for " << tmp);
+  CHECK(::rename(tmp.c_str(), path.c_str()) == 0,
+        "Could not rename " << tmp << " to " << path);
+
+  // Persist the rename itself.
+  const size_t slash = path.find_last_of('/');
+  const std::string dir = slash == std::string::npos ? "." : path.substr(0, slash);
+  int dfd = ::open(dir.empty() ? "/" : dir.c_str(), O_RDONLY);
+  if (dfd >= 0) {
+    ::fsync(dfd);
+    ::close(dfd);
+  }
+#else
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    CHECK(out.is_open(), "Could not open file for writing: " << tmp);
+    out.write(reinterpret_cast<const char *>(data), n);
+    out.close();
+    CHECK(!out.fail(), "Failed to write checkpoint " << tmp);
+  }
+  std::remove(path.c_str());
+  CHECK(std::rename(tmp.c_str(), path.c_str()) == 0,
+        "Could not rename " << tmp << " to " << path);
+#endif
+}
+
+std::vector<CheckpointSource> param_sources(const Module &model) {
+  std::vector<CheckpointSource> out;
+  for (const auto &p : model.named_parameters())
+    out.push_back({p.name, DType::F32, p.value->rows, p.value->cols,
+                   p.value->data.data()});
+  return out;
+}
+
+void save_v2(const std::vector<CheckpointSource> &sources,
+             const std::string &path) {
+  StagedCheckpoint s;
+  stage_v2(sources, s);
+  finalize_v2(s);
+  write_atomic(path, s.bytes.data(), s.bytes.size());
+}
+
+void load_v1(Module &model, const std::string &path) {
   std::ifstream in(path, std::ios::binary);
   CHECK(in.is_open(), "Could not open file for reading: " << path);
 
@@ -90,6 +310,368 @@ void load_checkpoint(Module &model, const std::string &path) {
             rows * cols * sizeof(float));
     CHECK(in.good(), "Failed to read data for parameter " << name);
   }
+  model.parameters_changed();
+}
+
+// Pairs every checkpoint entry with the model parameter of the same name
+// and checks shapes and dtypes.
+std::vector<std::pair<const CheckpointEntry *, Tensor *>>
+match_params(const std::vector<CheckpointEntry> &entries, Module &model) {
+  std::unordered_map<std::string, Tensor *> by_name;
+  for (auto &p : model.named_parameters())
+    by_name[p.name] = p.value;
+
+  std::vector<std::pair<const CheckpointEntry *, Tensor *>> out;
+  for (const auto &e : entries) {
+    if (e.name.find('#') != std::string::npos)
+      continue;
+    auto it = by_name.find(e.name);
+    CHECK(it != by_name.end(), "Checkpoint contains parameter '"
+                                   << e.name << "' which is not in the model");
+    Tensor *t = it->second;
+    CHECK(t->rows == e.rows && t->cols == e.cols,
+          "Shape mismatch for parameter '"
+              << e.name << "': checkpoint=(" << e.rows << "," << e.cols
+              << "), model=(" << t->rows << "," << t->cols << ")");
+    out.emplace_back(&e, t);
+  }
+  return out;
+}
+
+}  
+
+void save_checkpoint(const Module &model, const std::string &path,
+                     CheckpointFormat format) {
+  if (format == CheckpointFormat::V1)
+    save_v1(model, path);
+  else
+    save_v2(param_sources(model), path);
+}
+
+void save_checkpoint_entries(const std::vector<CheckpointSource> &sources,
+                             const std::string &path) {
+  save_v2(sources, path);
+}
+
+void save_checkpoint(const Module &model, const std::string &path,
+                     const CheckpointStorage &storage) {
+  auto params = model.named_parameters();
+  // Converted payloads; deque keeps each buffer in place as more are added.
+  std::deque<std::vector<uint8_t>> buffers;
+  std::deque<std::vector<float>> scale_buffers;
+  std::vector<CheckpointSource> sources;
+
+  for (const auto &p : params) {
+    const Tensor &t = *p.value;
+    const size_t n = t.size();
+    const DType dt = p.bias ? storage.vectors : storage.matrices;
+    const std::string &name = p.name;
+    switch (dt) {
+    case DType::F32:
+      sources.push_back({name, dt, t.rows, t.cols, t.data.data()});
+      break;
+    case DType::F16:
+    case DType::BF16: {
+      buffers.emplace_back(n * sizeof(uint16_t));
+      uint16_t *dst = reinterpret_cast<uint16_t *>(buffers.back().data());
+      if (dt == DType::F16)
+        f32_to_f16(t.data.data(), dst, n);
+      else
+        f32_to_bf16(t.data.data(), dst, n);
+      sources.push_back({name, dt, t.rows, t.cols, dst});
+      break;
+    }
+    case DType::I8: {
+      // Symmetric per-column codes: scale = absmax / 127.
+      const size_t cols = (size_t)t.cols;
+      std::vector<float> &scale = scale_buffers.emplace_back(cols, 0.0f);
+      for (int r = 0; r < t.rows; ++r) {
+        const float *row = t.data.data() + (size_t)r * cols;
+        for (size_t c = 0; c < cols; ++c) {
+          CHECK(!is_nonfinite(row[c]),
+                "Cannot store parameter '" << name << "' as i8: non-finite "
+                                           << "value at (" << r << ", " << c
+                                           << ")");
+          scale[c] = std::max(scale[c], std::fabs(row[c]));
+        }
+      }
+      std::vector<float> inv(cols);
+      for (size_t c = 0; c < cols; ++c) {
+        scale[c] = scale[c] > 0.0f ? scale[c] / 127.0f : 1.0f;
+        inv[c] = 1.0f / scale[c];
+      }
+      buffers.emplace_back(n);
+      int8_t *codes = reinterpret_cast<int8_t *>(buffers.back().data());
+#pragma omp parallel for schedule(static) if (n >= ((size_t)1 << 16))
+      for (int r = 0; r < t.rows; ++r) {
+        const float *row = t.data.data() + (size_t)r * cols;
+        int8_t *q = codes + (size_t)r * cols;
+        for (size_t c = 0; c < cols; ++c) {
+          const float v = std::nearbyint(row[c] * inv[c]);
+          q[c] = (int8_t)std::min(127.0f, std::max(-127.0f, v));
+        }
+      }
+      sources.push_back({name, dt, t.rows, t.cols, codes});
+      sources.push_back(
+          {name + "#scale", DType::F32, 1, t.cols, scale.data()});
+      break;
+    }
+    default:
+      THROW_ERROR("Unsupported checkpoint storage dtype "
+                  << dtype_name(dt) << " for parameter '" << name << "'");
+    }
+  }
+  save_v2(sources, path);
+}
+
+void load_checkpoint(Module &model, const std::string &path) {
+  char magic[4] = {0};
+  {
+    std::ifstream in(path, std::ios::binary);
+    CHECK(in.is_open(), "Could not open file for reading: " << path);
+    in.read(magic, 4);
+  }
+  if (std::memcmp(magic, MAGIC_V2, 4) == 0) {
+    CheckpointReader reader(path);
+    if (is_delta_checkpoint(reader))
+      load_delta_checkpoint(model, path);
+    else
+      reader.load_into(model);
+  } else
+    load_v1(model, path);
+}
+
+CheckpointReader::CheckpointReader(const std::string &path, bool verify)
+    : file_(path, /*copy_on_write=*/true) {
+  const uint8_t *base = file_.data();
+  const size_t size = file_.size();
+  CHECK(size >= sizeof(V2Header), "Invalid checkpoint file (too small): "
+                                      << path);
+  V2Header h;
+  std::memcpy(&h, base, sizeof(h));
+  CHECK(std::memcmp(h.magic, MAGIC_V2, 4) == 0,
+        "Invalid checkpoint file: wrong magic header");
+  CHECK(h.version == VERSION_V2, "Unsupported checkpoint version: "
+                                     << h.version);
+  CHECK(h.file_bytes <= size && h.index_offset + h.index_bytes <= size,
+        "Truncated checkpoint file: " << path);
+  CHECK(crc32c(base + h.index_offset, h.index_bytes) == h.index_crc,
+        "Checkpoint index checksum mismatch in " << path);
+
+  const uint8_t *p = base + h.index_offset;
+  const uint8_t *end = p + h.index_bytes;
+  entries_.resize(h.num_tensors);
+  for (auto &e : entries_) {
+    const uint32_t len = take<uint32_t>(p, end);
+    CHECK(p + len <= end, "Corrupt checkpoint index (name)");
+    e.name.assign(reinterpret_cast<const char *>(p), len);
+    p += len;
+    e.dtype = (DType)take<uint32_t>(p, end);
+    e.rows = take<int32_t>(p, end);
+    e.cols = take<int32_t>(p, end);
+    e.offset = take<uint64_t>(p, end);
+    e.nbytes = take<uint64_t>(p, end);
+    e.crc = take<uint32_t>(p, end);
+    CHECK(e.offset % kAlign == 0 && e.offset <= size &&
+              e.nbytes <= size - e.offset,
+          "Corrupt checkpoint entry '" << e.name << "'");
+    // Two negative dims would multiply to a plausible positive size.
+    CHECK(e.rows >= 0 && e.cols >= 0 &&
+              e.nbytes == (uint64_t)e.rows * e.cols * dtype_size(e.dtype),
+          "Corrupt checkpoint entry '" << e.name << "' (size)");
+  }
+  for (size_t i = 0; i < entries_.size(); ++i)
+    by_name_[entries_[i].name] = i;
+
+  if (verify)
+    verify_payloads();
+}
+
+void CheckpointReader::verify_payloads() const {
+  const long n = (long)entries_.size();
+  std::vector<char> bad(n, 0);
+#pragma omp parallel for schedule(dynamic)
+  for (long i = 0; i < n; ++i) {
+    const CheckpointEntry &e = entries_[i];
+    bad[i] = crc32c(payload(e), e.nbytes) != e.crc;
+  }
+  for (long i = 0; i < n; ++i)
+    CHECK(!bad[i], "Checksum mismatch for parameter '" << entries_[i].name
+                                                       << "' in "
+                                                       << file_.path());
+}
+
+const CheckpointEntry *CheckpointReader::find(const std::string &name) const {
+  auto it = by_name_.find(name);
+  return it == by_name_.end() ? nullptr : &entries_[it->second];
+}
+
+const float *CheckpointReader::scales(const CheckpointEntry &e) const {
+  if (e.dtype != DType::I8)
+    return nullptr;
+  const CheckpointEntry *s = find(e.name + "#scale");
+  CHECK(s && s->dtype == DType::F32 && s->rows == 1 && s->cols == e.cols,
+        "Missing scales for int8 parameter '" << e.name << "'");
+  return static_cast<const float *>(payload(*s));
+}
+
+void CheckpointReader::decode(const CheckpointEntry &e, const float *scale,
+                              size_t begin, size_t end, float *dst) const {
+  const void *src = payload(e);
+  switch (e.dtype) {
+  case DType::F32:
+    std::memcpy(dst + begin, static_cast<const float *>(src) + begin,
+                (end - begin) * sizeof(float));
+    break;
+  case DType::F16:
+    f16_to_f32(static_cast<const uint16_t *>(src) + begin, dst + begin,
+               end - begin);
+    break;
+  case DType::BF16:
+    bf16_to_f32(static_cast<const uint16_t *>(src) + begin, dst + begin,
+                end - begin);
+    break;
+  case DType::I8: {
+    // Runs of one row at a time, so the inner loop is a plain vector
+    // multiply by the column scales.
+    const int8_t *codes = static_cast<const int8_t *>(src);
+    const size_t cols = (size_t)e.cols;
+    for (size_t i = begin; i < end;) {
+      const size_t c = i % cols;
+      const size_t run = std::min(end - i, cols - c);
+      const int8_t *q = codes + i;
+      const float *sc = scale + c;
+      float *out = dst + i;
+#pragma omp simd
+      for (size_t k = 0; k < run; ++k)
+        out[k] = (float)q[k] * sc[k];
+      i += run;
+    }
+    break;
+  }
+  default:
+    THROW_ERROR("Cannot decode parameter '" << e.name << "' stored as "
+                                            << dtype_name(e.dtype));
+  }
+}
+
+void CheckpointReader::read_f32(const CheckpointEntry &e, float *dst) const {
+  decode(e, scales(e), 0, (size_t)e.rows * e.cols, dst);
+}
+
+void CheckpointReader::load_into(Module &model) const {
+  auto pairs = match_params(entries_, model);
+
+  struct Piece {
+    const CheckpointEntry *e;
+    const float *scale;
+    size_t begin;
+    size_t end;
+    float *dst;
+  };
+  const size_t chunk = kCopyChunk / sizeof(float);
+  std::vector<Piece> pieces;
+  for (auto &pr : pairs) {
+    const CheckpointEntry &e = *pr.first;
+    const float *scale = scales(e);
+    const size_t n = (size_t)e.rows * e.cols;
+    for (size_t begin = 0; begin < n; begin += chunk)
+      pieces.push_back({&e, scale, begin, std::min(n, begin + chunk),
+                        pr.second->data.data()});
+  }
+
+  // decode() throws only for unknown dtypes; check those up front so no
+  // exception escapes the parallel region.
+  for (auto &pr : pairs) {
+    const DType dt = pr.first->dtype;
+    CHECK(dt == DType::F32 || dt == DType::F16 || dt == DType::BF16 ||
+              dt == DType::I8,
+          "Cannot decode parameter '" << pr.first->name << "' stored as "
+                                      << dtype_name(dt));
+  }
+
+#pragma omp parallel for schedule(dynamic) if (pieces.size() > 1)
+  for (long i = 0; i < (long)pieces.size(); ++i)
+    decode(*pieces[i].e, pieces[i].scale, pieces[i].begin, pieces[i].end,
+           pieces[i].dst);
+  model.parameters_changed();
+}
+
+void CheckpointReader::bind(Module &model) {
+  auto pairs = match_params(entries_, model);
+  for (auto &pr : pairs)
+    CHECK(pr.first->dtype == DType::F32,
+          "Cannot bind parameter '" << pr.first->name << "' stored as "
+                                    << dtype_name(pr.first->dtype));
+  for (auto &pr : pairs) {
+    float *ptr = static_cast<float *>(mutable_payload(*pr.first));
+    pr.second->rebind(Tensor::view(ptr, pr.first->rows, pr.first->cols));
+  }
+  model.parameters_changed();
+}
+
+AsyncCheckpointWriter::AsyncCheckpointWriter() {
+  staged_[0].reset(new StagedCheckpoint);
+  staged_[1].reset(new StagedCheckpoint);
+  worker_ = std::thread(&AsyncCheckpointWriter::run, this);
+}
+
+AsyncCheckpointWriter::~AsyncCheckpointWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  worker_.join(); // drains the queue first
+}
+
+void AsyncCheckpointWriter::run() {
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+      if (jobs_.empty())
+        return;
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    try {
+      finalize_v2(*job.staged);
+      write_atomic(job.path, job.staged->bytes.data(),
+                   job.staged->bytes.size());
+      job.done.set_value();
+    } catch (...) {
+      job.done.set_exception(std::current_exception());
+    }
+  }
+}
+
+std::shared_future<void>
+AsyncCheckpointWriter::save(const Module &model, const std::string &path) {
+  const int k = next_;
+  next_ ^= 1;
+  // This buffer may still be feeding the write before last.
+  if (done_[k].valid())
+    done_[k].wait();
+
+  StagedCheckpoint *s = staged_[k].get();
+  stage_v2(param_sources(model), *s);
+
+  Job job{s, path, std::promise<void>()};
+  done_[k] = job.done.get_future().share();
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    jobs_.push_back(std::move(job));
+  }
+  cv_.notify_one();
+  return done_[k];
+}
+
+void AsyncCheckpointWriter::wait() {
+  for (auto &d : done_)
+    if (d.valid())
+      d.wait();
 }
 
 }  
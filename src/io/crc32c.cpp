@@ -0,0 +1,56 @@
+#include "io/crc32c.h"
+#include <cstring>
+
+namespace tf {
+
+namespace {
+
+struct Tables {
+  uint32_t t[8][256];
+  Tables() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k)
+        c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1u)));
+      t[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; ++i)
+      for (int s = 1; s < 8; ++s)
+        t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff];
+  }
+};
+
+}  
+
+uint32_t crc32c(const void *data, size_t n, uint32_t crc) {
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  uint32_t c = ~crc;
+
+#if defined(__SSE4_2__) && defined(__x86_64__)
+  for (; n >= 8; n -= 8, p += 8) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    c = (uint32_t)__builtin_ia32_crc32di(c, v);
+  }
+  for (; n > 0; --n, ++p)
+    c = __builtin_ia32_crc32qi(c, *p);
+#else
+  static const Tables tables;
+  const auto &t = tables.t;
+  for (; n >= 8; n -= 8, p += 8) {
+    uint32_t lo, hi;
+    std::memcpy(&lo, p, 4);
+    std::memcpy(&hi, p + 4, 4);
+    lo ^= c;
+    c = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^
+        t[4][lo >> 24] ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+        t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+  }
+  for (; n > 0; --n, ++p)
+    c = (c >> 8) ^ t[0][(c ^ *p) & 0xff];
+#endif
+
+  return ~c;
+}
+
+}  
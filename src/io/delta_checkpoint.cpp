@@ -0,0 +1,260 @@
+#include "io/delta_checkpoint.h"
+#include "core/error.h"
+#include "nn/module.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+namespace tf {
+
+namespace {
+
+const uint32_t kDeltaVersion = 1;
+
+struct DeltaMeta {
+  uint32_t version;
+  uint32_t block_elems;
+  uint64_t seq;
+};
+
+std::string dir_of(const std::string &path) {
+  const size_t slash = path.find_last_of('/');
+  return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+DeltaMeta read_meta(const CheckpointReader &r) {
+  const CheckpointEntry *e = r.find("#delta");
+  CHECK(e && e->nbytes == sizeof(DeltaMeta),
+        "Not a delta checkpoint: " << r.path());
+  DeltaMeta m;
+  std::memcpy(&m, r.payload(*e), sizeof(m));
+  CHECK(m.version == kDeltaVersion,
+        "Unsupported delta checkpoint version: " << m.version);
+  return m;
+}
+
+std::string parent_of(const CheckpointReader &r) {
+  const CheckpointEntry *e = r.find("#parent");
+  CHECK(e, "Delta checkpoint has no parent: " << r.path());
+  std::string parent(static_cast<const char *>(r.payload(*e)), e->nbytes);
+  if (parent.find('/') == std::string::npos)
+    parent = dir_of(r.path()) + parent;
+  return parent;
+}
+
+// Opens every file of the chain ending at `path`, base first, checking
+// that each delta follows its parent.
+std::vector<std::unique_ptr<CheckpointReader>>
+open_chain(const std::string &path) {
+  std::vector<std::unique_ptr<CheckpointReader>> chain;
+  std::string cur = path;
+  uint64_t tip_seq = 0;
+  for (;;) {
+    chain.emplace_back(new CheckpointReader(cur));
+    const CheckpointReader &r = *chain.back();
+    if (!is_delta_checkpoint(r))
+      break;
+    if (chain.size() == 1)
+      tip_seq = read_meta(r).seq;
+    CHECK(chain.size() <= tip_seq, "Broken delta checkpoint chain at " << cur);
+    cur = parent_of(r);
+  }
+  std::reverse(chain.begin(), chain.end());
+  for (size_t i = 1; i < chain.size(); ++i)
+    CHECK(read_meta(*chain[i]).seq == i,
+          "Delta checkpoint " << chain[i]->path()
+                              << " does not follow its parent");
+  return chain;
+}
+
+// Writes the blocks that delta `r` stores for tensor `name` into dst
+// (n elements).
+void apply_blocks(const CheckpointReader &r, const DeltaMeta &m,
+                  const std::string &name, float *dst, size_t n) {
+  const CheckpointEntry *ids_e = r.find(name + "#blocks");
+  if (!ids_e)
+    return;
+  const CheckpointEntry *data_e = r.find(name + "#data");
+  const size_t count = ids_e->nbytes / sizeof(uint32_t);
+  CHECK(data_e && data_e->rows == (int)count &&
+            data_e->cols == (int)m.block_elems,
+        "Corrupt delta entry '" << name << "' in " << r.path());
+  const uint32_t *ids = static_cast<const uint32_t *>(r.payload(*ids_e));
+  const float *data = static_cast<const float *>(r.payload(*data_e));
+  for (size_t i = 0; i < count; ++i)
+    CHECK((size_t)ids[i] * m.block_elems < n,
+          "Delta block out of range for '" << name << "' in " << r.path());
+
+#pragma omp parallel for schedule(static) if (count > 64)
+  for (long i = 0; i < (long)count; ++i) {
+    const size_t begin = (size_t)ids[i] * m.block_elems;
+    const size_t len = std::min<size_t>(m.block_elems, n - begin);
+    std::memcpy(dst + begin, data + (size_t)i * m.block_elems,
+                len * sizeof(float));
+  }
+}
+
+}  
+
+bool is_delta_checkpoint(const CheckpointReader &reader) {
+  return reader.find("#delta") != nullptr;
+}
+
+DeltaCheckpointWriter::DeltaCheckpointWriter(size_t block_elems,
+                                             size_t max_chain)
+    : block_elems_(block_elems), max_chain_(max_chain) {
+  CHECK(block_elems_ > 0, "Delta block size must be positive");
+}
+
+void DeltaCheckpointWriter::reset() {
+  seq_ = 0;
+  chain_.clear();
+  shadow_.clear();
+}
+
+DeltaStats DeltaCheckpointWriter::save(const Module &model,
+                                       const std::string &path) {
+  auto params = model.named_parameters();
+  DeltaStats stats;
+
+  // Overwriting a file of the current chain would cut the chain (a delta
+  // saved over its own parent points at itself), so that starts a new one.
+  bool full = chain_.empty() || (max_chain_ > 0 && seq_ >= max_chain_) ||
+              std::find(chain_.begin(), chain_.end(), path) != chain_.end();
+  for (size_t i = 0; !full && i < params.size(); ++i) {
+    auto it = shadow_.find(params[i].name);
+    full = it == shadow_.end() || it->second.size() != params[i].value->size();
+  }
+
+  if (full) {
+    save_checkpoint(model, path);
+    shadow_.clear();
+    for (const auto &p : params) {
+      shadow_[p.name].assign(p.value->data.begin(), p.value->data.end());
+      stats.blocks_total += (p.value->size() + block_elems_ - 1) / block_elems_;
+    }
+    stats.full = true;
+    stats.tensors_changed = params.size();
+    stats.blocks_changed = stats.blocks_total;
+    seq_ = 0;
+    chain_.clear();
+  } else {
+    // Find changed blocks. The shadow is only updated once the delta is on
+    // disk, so a failed write leaves them dirty for the next save.
+    std::vector<std::vector<uint32_t>> changed(params.size());
+    for (size_t t = 0; t < params.size(); ++t) {
+      const float *cur = params[t].value->data.data();
+      const float *old = shadow_[params[t].name].data();
+      const size_t n = params[t].value->size();
+      const long blocks = (long)((n + block_elems_ - 1) / block_elems_);
+      std::vector<char> dirty(blocks, 0);
+#pragma omp parallel for schedule(static) if (n >= ((size_t)1 << 16))
+      for (long b = 0; b < blocks; ++b) {
+        const size_t begin = (size_t)b * block_elems_;
+        const size_t bytes = std::min(block_elems_, n - begin) * sizeof(float);
+        if (std::memcmp(cur + begin, old + begin, bytes) != 0)
+          dirty[b] = 1;
+      }
+      for (long b = 0; b < blocks; ++b)
+        if (dirty[b])
+          changed[t].push_back((uint32_t)b);
+      stats.blocks_total += blocks;
+    }
+
+    // Gather changed blocks into one buffer per tensor.
+    std::vector<std::vector<float>> data(params.size());
+    std::vector<std::string> names;
+    names.reserve(2 * params.size());
+    std::vector<CheckpointSource> sources;
+    for (size_t t = 0; t < params.size(); ++t) {
+      if (changed[t].empty())
+        continue;
+      const float *src = params[t].value->data.data();
+      const size_t n = params[t].value->size();
+      data[t].assign(changed[t].size() * block_elems_, 0.0f);
+      for (size_t i = 0; i < changed[t].size(); ++i) {
+        const size_t begin = (size_t)changed[t][i] * block_elems_;
+        std::memcpy(data[t].data() + i * block_elems_, src + begin,
+                    std::min(block_elems_, n - begin) * sizeof(float));
+      }
+      sources.push_back({params[t].name + "#blocks", DType::U8, 1,
+                         (int)(changed[t].size() * sizeof(uint32_t)),
+                         changed[t].data()});
+      sources.push_back({params[t].name + "#data", DType::F32,
+                         (int)changed[t].size(), (int)block_elems_,
+                         data[t].data()});
+      ++stats.tensors_changed;
+      stats.blocks_changed += changed[t].size();
+    }
+
+    DeltaMeta meta{kDeltaVersion, (uint32_t)block_elems_, seq_ + 1};
+    std::string parent = chain_.back();
+    if (dir_of(parent) == dir_of(path))
+      parent = parent.substr(dir_of(parent).size());
+    sources.push_back({"#delta", DType::U8, 1, (int)sizeof(meta), &meta});
+    sources.push_back(
+        {"#parent", DType::U8, 1, (int)parent.size(), parent.data()});
+    save_checkpoint_entries(sources, path);
+
+    for (size_t t = 0; t < params.size(); ++t) {
+      const float *cur = params[t].value->data.data();
+      float *old = shadow_[params[t].name].data();
+      const size_t n = params[t].value->size();
+      for (uint32_t b : changed[t]) {
+        const size_t begin = (size_t)b * block_elems_;
+        std::memcpy(old + begin, cur + begin,
+                    std::min(block_elems_, n - begin) * sizeof(float));
+      }
+    }
+    ++seq_;
+  }
+
+  chain_.push_back(path);
+  std::ifstream written(path, std::ios::binary | std::ios::ate);
+  stats.bytes_written = (size_t)written.tellg();
+  return stats;
+}
+
+std::vector<std::string> checkpoint_chain(const std::string &path) {
+  std::vector<std::string> out;
+  for (const auto &r : open_chain(path))
+    out.push_back(r->path());
+  return out;
+}
+
+void load_delta_checkpoint(Module &model, const std::string &path) {
+  auto chain = open_chain(path);
+  chain.front()->load_into(model);
+  auto params = model.named_parameters();
+  for (size_t i = 1; i < chain.size(); ++i) {
+    const DeltaMeta m = read_meta(*chain[i]);
+    for (auto &p : params)
+      apply_blocks(*chain[i], m, p.name, p.value->data.data(),
+                   p.value->size());
+  }
+  model.parameters_changed();
+}
+
+void compact_checkpoint(const std::string &path, const std::string &out) {
+  auto chain = open_chain(path);
+  const CheckpointReader &base = *chain.front();
+
+  std::vector<std::vector<float>> values(base.entries().size());
+  std::vector<CheckpointSource> sources;
+  for (size_t i = 0; i < base.entries().size(); ++i) {
+    const CheckpointEntry &e = base.entries()[i];
+    if (e.name.find('#') != std::string::npos)
+      continue;
+    values[i].resize((size_t)e.rows * e.cols);
+    base.read_f32(e, values[i].data());
+    for (size_t d = 1; d < chain.size(); ++d)
+      apply_blocks(*chain[d], read_meta(*chain[d]), e.name, values[i].data(),
+                   values[i].size());
+    sources.push_back({e.name, DType::F32, e.rows, e.cols, values[i].data()});
+  }
+  save_checkpoint_entries(sources, out);
+}
+
+}  
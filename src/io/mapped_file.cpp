@@ -0,0 +1,132 @@
+#include "io/mapped_file.h"
+#include "core/error.h"
+#include <fstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TF_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tf {
+
+MappedFile::MappedFile(const std::string &path, bool copy_on_write)
+    : path_(path), writable_(copy_on_write) {
+#ifdef TF_HAVE_MMAP
+  int fd = ::open(path.c_str(), O_RDONLY);
+  CHECK(fd >= 0, "Could not open file for mapping: " << path);
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    THROW_ERROR("Could not stat file: " << path);
+  }
+  size_ = (size_t)st.st_size;
+  if (size_ > 0) {
+    const int prot = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+    int flags = MAP_PRIVATE;
+#ifdef MAP_NORESERVE
+    // A writable private mapping is otherwise commit-charged for its full
+    // length, which fails for files larger than RAM + swap.
+    if (copy_on_write)
+      flags |= MAP_NORESERVE;
+#endif
+    void *p = ::mmap(nullptr, size_, prot, flags, fd, 0);
+    ::close(fd);
+    CHECK(p != MAP_FAILED, "mmap failed for " << path);
+    data_ = static_cast<const uint8_t *>(p);
+  } else {
+    ::close(fd);
+  }
+#else
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  CHECK(in.is_open(), "Could not open file for mapping: " << path);
+  size_ = (size_t)in.tellg();
+  fallback_.resize(size_);
+  in.seekg(0);
+  in.read(reinterpret_cast<char *>(fallback_.data()), size_);
+  CHECK(in.good(), "Failed to read " << path);
+  data_ = fallback_.data();
+#endif
+}
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    path_ = std::move(other.path_);
+    data_ = other.data_;
+    size_ = other.size_;
+    writable_ = other.writable_;
+    fallback_ = std::move(other.fallback_);
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+uint8_t *MappedFile::mutable_data() const {
+  CHECK(writable_, "MappedFile " << path_ << " is not copy-on-write");
+  return const_cast<uint8_t *>(data_);
+}
+
+void MappedFile::close() {
+#ifdef TF_HAVE_MMAP
+  if (data_ && size_ > 0)
+    ::munmap(const_cast<uint8_t *>(data_), size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  fallback_.clear();
+}
+
+#ifdef TF_HAVE_MMAP
+namespace {
+
+// madvise needs a page-aligned start; widen the range down to a page.
+void advise_range(const uint8_t *base, size_t size, size_t offset, size_t len,
+                  int advice) {
+  if (!base || offset >= size)
+    return;
+  if (len == 0 || offset + len > size)
+    len = size - offset;
+  static const size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+  const size_t start = offset / page * page;
+  ::madvise(const_cast<uint8_t *>(base) + start, len + (offset - start),
+            advice);
+}
+
+}  
+#endif
+
+void MappedFile::advise(Access access, size_t offset, size_t len) const {
+#ifdef TF_HAVE_MMAP
+  int advice = MADV_NORMAL;
+  if (access == Access::Sequential)
+    advice = MADV_SEQUENTIAL;
+  else if (access == Access::Random)
+    advice = MADV_RANDOM;
+  advise_range(data_, size_, offset, len, advice);
+#else
+  (void)access;
+  (void)offset;
+  (void)len;
+#endif
+}
+
+void MappedFile::prefetch(size_t offset, size_t len) const {
+#ifdef TF_HAVE_MMAP
+  if (len > 0)
+    advise_range(data_, size_, offset, len, MADV_WILLNEED);
+#else
+  (void)offset;
+  (void)len;
+#endif
+}
+
+}  
@@ -0,0 +1,91 @@
+#include "io/training_state.h"
+#include "data/dataloader.h"
+#include "nn/module.h"
+#include "optim/adam.h"
+#include <cstring>
+
+namespace tf {
+
+TrainingState::TrainingState(const std::string &path)
+    : reader_(new CheckpointReader(path)) {
+  for (const auto &e : reader_->entries())
+    by_name_[e.name] = &e;
+}
+
+void TrainingState::put(const std::string &name, const float *data, int rows,
+                        int cols) {
+  sources_.push_back({name, DType::F32, rows, cols, data});
+}
+
+void TrainingState::put_bytes(const std::string &name, const void *data,
+                              size_t bytes) {
+  sources_.push_back({name, DType::U8, 1, (int)bytes, data});
+}
+
+void TrainingState::save(const std::string &path) const {
+  save_checkpoint_entries(sources_, path);
+}
+
+bool TrainingState::contains(const std::string &name) const {
+  return by_name_.count(name) != 0;
+}
+
+const CheckpointEntry &TrainingState::entry(const std::string &name) const {
+  CHECK(reader_, "TrainingState was not loaded from a file");
+  auto it = by_name_.find(name);
+  CHECK(it != by_name_.end(), "Training state has no entry '" << name << "'");
+  return *it->second;
+}
+
+void TrainingState::get(const std::string &name, float *dst, int rows,
+                        int cols) const {
+  const CheckpointEntry &e = entry(name);
+  CHECK(e.dtype == DType::F32 && e.rows == rows && e.cols == cols,
+        "Shape mismatch for '" << name << "': state=(" << e.rows << ","
+                               << e.cols << "), expected=(" << rows << ","
+                               << cols << ")");
+  if (e.nbytes > 0)
+    std::memcpy(dst, reader_->payload(e), e.nbytes);
+}
+
+size_t TrainingState::bytes(const std::string &name) const {
+  return entry(name).nbytes;
+}
+
+void TrainingState::get_bytes(const std::string &name, void *dst,
+                              size_t bytes) const {
+  const CheckpointEntry &e = entry(name);
+  CHECK(e.nbytes == bytes, "Size mismatch for '" << name << "': state="
+                                                 << e.nbytes
+                                                 << " bytes, expected="
+                                                 << bytes);
+  if (bytes > 0)
+    std::memcpy(dst, reader_->payload(e), bytes);
+}
+
+void save_training_state(const std::string &path, const Module &model,
+                         const Adam &optim, const DataLoader &loader,
+                         int epoch) {
+  auto params = model.named_parameters();
+  TrainingState state;
+  state.put_value("epoch", (int32_t)epoch);
+  for (const auto &p : params)
+    state.put("model/" + p.name, *p.value);
+  optim.export_state(params, state);
+  loader.export_state(state);
+  state.save(path);
+}
+
+int load_training_state(const std::string &path, Module &model, Adam &optim,
+                        DataLoader &loader) {
+  TrainingState state(path);
+  auto params = model.named_parameters();
+  for (auto &p : params)
+    state.get("model/" + p.name, *p.value);
+  model.parameters_changed();
+  optim.import_state(params, state);
+  loader.import_state(state);
+  return state.value<int32_t>("epoch");
+}
+
+}  
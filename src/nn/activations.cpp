@@ -1,24 +1,69 @@
 #include "nn/activations.h"
+#include "core/dtype.h"
+#include "core/error.h"
 #include "core/math.h"
 
 namespace tf {
 
 Tensor ReLU::forward(const Tensor& x) {
-  x_cache = x;
+  if (precision_ == Precision::BF16) {
+    x_cache_bf16.resize(x.size());
+    f32_to_bf16(x.data.data(), x_cache_bf16.data(), x.size());
+  } else {
+    x_cache = x;
+  }
   return relu(x);
 }
 
 Tensor ReLU::backward(const Tensor& grad_out) {
-  return relu_backward(x_cache, grad_out);
+  if (precision_ == Precision::FP32)
+    return relu_backward(x_cache, grad_out);
+  // Rounding to bf16 keeps the sign, so the mask is exact.
+  CHECK(grad_out.size() == x_cache_bf16.size(),
+        "ReLU backward mismatch: grad_out " << grad_out.shape_str());
+  Tensor dX(grad_out.rows, grad_out.cols);
+  for (size_t i = 0; i < dX.size(); ++i)
+    dX.data[i] = bf16_to_f32(x_cache_bf16[i]) > 0.0f ? grad_out.data[i] : 0.0f;
+  return dX;
+}
+
+Module* ReLU::clone() const { return new ReLU(*this); }
+
+void ReLU::set_precision(Precision p) {
+  precision_ = p;
+  x_cache = Tensor();
+  x_cache_bf16.clear();
+  x_cache_bf16.shrink_to_fit();
 }
 
 Tensor Sigmoid::forward(const Tensor& x) {
-  y_cache = sigmoid(x);
-  return y_cache;
+  Tensor y = sigmoid(x);
+  if (precision_ == Precision::BF16) {
+    y_cache_bf16.resize(y.size());
+    f32_to_bf16(y.data.data(), y_cache_bf16.data(), y.size());
+    rows_ = y.rows;
+    cols_ = y.cols;
+  } else {
+    y_cache = y;
+  }
+  return y;
 }
 
 Tensor Sigmoid::backward(const Tensor& grad_out) {
-  return sigmoid_backward_from_output(y_cache, grad_out);
+  if (precision_ == Precision::FP32)
+    return sigmoid_backward_from_output(y_cache, grad_out);
+  Tensor y(rows_, cols_);
+  bf16_to_f32(y_cache_bf16.data(), y.data.data(), y.size());
+  return sigmoid_backward_from_output(y, grad_out);
+}
+
+Module* Sigmoid::clone() const { return new Sigmoid(*this); }
+
+void Sigmoid::set_precision(Precision p) {
+  precision_ = p;
+  y_cache = Tensor();
+  y_cache_bf16.clear();
+  y_cache_bf16.shrink_to_fit();
 }
 
 }
@@ -0,0 +1,142 @@
+#include "nn/data_parallel.h"
+#include "core/error.h"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+namespace tf {
+
+// Reduction block in floats (16 KiB): every replica's slice of a block stays
+// in L1/L2 while it is summed.
+static const size_t kReduceBlock = 4096;
+
+static void copy_rows(const Tensor &src, int begin, int count, Tensor &dst) {
+  if (dst.rows != count || dst.cols != src.cols)
+    dst = Tensor(count, src.cols);
+  std::memcpy(dst.data.data(), src.data.data() + (size_t)begin * src.cols,
+              (size_t)count * src.cols * sizeof(float));
+}
+
+DataParallel::DataParallel(Sequential &model, int num_replicas)
+    : params_(model.params()) {
+  CHECK(num_replicas >= 1,
+        "DataParallel needs at least one replica, got " << num_replicas);
+
+  for (int r = 0; r < num_replicas; ++r) {
+    replicas_.emplace_back(model.clone());
+    arenas_.emplace_back(new ParamArena(*replicas_.back()));
+    CHECK(arenas_.back()->params().size() == params_.size(),
+          "DataParallel replica parameter count mismatch");
+  }
+
+  shard_x_.resize(num_replicas);
+  shard_y_.resize(num_replicas);
+  shard_loss_.resize(num_replicas, 0.0f);
+
+  const ParamArena &layout = *arenas_[0];
+  for (size_t p = 0; p < params_.size(); ++p) {
+    const size_t n = params_[p].grad->size();
+    for (size_t begin = 0; begin < n; begin += kReduceBlock)
+      blocks_.push_back(
+          {p, begin, std::min(n, begin + kReduceBlock), layout.offset(p)});
+  }
+}
+
+void DataParallel::broadcast() {
+  for (auto &arena : arenas_) {
+    for (size_t p = 0; p < params_.size(); ++p) {
+      const Tensor &src = *params_[p].value;
+      std::memcpy(arena->values() + arena->offset(p), src.data.data(),
+                  src.size() * sizeof(float));
+    }
+    arena->zero_grad();
+  }
+}
+
+// Pairwise tree over replicas, parallel over fixed-size blocks of each
+// gradient tensor. The summation order only depends on the replica count, so
+// results are reproducible regardless of how blocks land on threads.
+void DataParallel::allreduce(int active) {
+  const long num_blocks = (long)blocks_.size();
+
+#pragma omp parallel for schedule(static)
+  for (long bi = 0; bi < num_blocks; ++bi) {
+    const Block &blk = blocks_[bi];
+    const size_t len = blk.end - blk.begin;
+    const size_t at = blk.arena_offset + blk.begin;
+
+    for (int stride = 1; stride < active; stride *= 2) {
+      for (int r = 0; r + stride < active; r += 2 * stride) {
+        float *dst = arenas_[r]->grads() + at;
+        const float *src = arenas_[r + stride]->grads() + at;
+        for (size_t i = 0; i < len; ++i)
+          dst[i] += src[i];
+      }
+    }
+
+    float *out = params_[blk.param].grad->data.data() + blk.begin;
+    const float *sum = arenas_[0]->grads() + at;
+    for (size_t i = 0; i < len; ++i)
+      out[i] += sum[i];
+  }
+}
+
+float DataParallel::forward_backward(const Tensor &x, const Tensor &y,
+                                     const LossFn &loss_fn) {
+  CHECK(x.rows == y.rows, "DataParallel batch mismatch: x "
+                              << x.shape_str() << ", y " << y.shape_str());
+  CHECK(x.rows > 0, "DataParallel received an empty batch");
+
+  const int total = x.rows;
+  const int active = std::min(num_replicas(), total);
+  const int base = total / active;
+  const int extra = total % active;
+
+  broadcast();
+
+  int offset = 0;
+  for (int r = 0; r < active; ++r) {
+    const int rows = base + (r < extra ? 1 : 0);
+    copy_rows(x, offset, rows, shard_x_[r]);
+    copy_rows(y, offset, rows, shard_y_[r]);
+    offset += rows;
+  }
+
+  std::vector<std::exception_ptr> errors(active);
+
+#pragma omp parallel for num_threads(active) schedule(static, 1)
+  for (int r = 0; r < active; ++r) {
+    try {
+      Module &replica = *replicas_[r];
+      Tensor logits = replica.forward(shard_x_[r]);
+
+      Tensor d_logits;
+      const float loss = loss_fn(logits, shard_y_[r], d_logits);
+
+      // Loss functions average over the shard; rescale so the summed
+      // gradient equals the full-batch mean gradient.
+      const float weight = (float)shard_x_[r].rows / (float)total;
+      for (auto &g : d_logits.data)
+        g *= weight;
+      shard_loss_[r] = loss * weight;
+
+      replica.backward(d_logits);
+    } catch (...) {
+      errors[r] = std::current_exception();
+    }
+  }
+
+  for (auto &e : errors) {
+    if (e)
+      std::rethrow_exception(e);
+  }
+
+  allreduce(active);
+
+  float loss = 0.0f;
+  for (int r = 0; r < active; ++r)
+    loss += shard_loss_[r];
+  return loss;
+}
+
+}  
@@ -1,4 +1,5 @@
 #include "nn/dense.h"
+#include "core/dtype.h"
 #include "core/error.h"
 #include "core/math.h"
 #include <cassert>
@@ -14,29 +15,112 @@ Dense::Dense(int in_features, int out_features, RNG &rng, bool he_init)
     xavier_uniform_(W, rng);
 }
 
+// Gradient accumulation is in place: dW/db may be views into a ParamArena.
+// A released (empty) gradient is treated as zero and simply takes cur.
+static void accumulate(Tensor &acc, Tensor cur) {
+  if (acc.size() == 0 && !acc.is_view())
+    acc = std::move(cur);
+  else
+    add_inplace(acc, cur);
+}
+
 Tensor Dense::forward(const Tensor &x) {
   CHECK(x.cols == W.rows, "Dense forward mismatch: input "
                               << x.shape_str() << " expected cols=" << W.rows);
-  x_cache = x;
-  Tensor y = matmul(x, W);
-  y = add_bias_rowwise(y, b);
+  x_rows = x.rows;
+  x_cols = x.cols;
+  if (training_) {
+    if (precision_ == Precision::BF16) {
+      x_cache_bf16.resize(x.size());
+      f32_to_bf16(x.data.data(), x_cache_bf16.data(), x.size());
+    } else {
+      x_cache = x;
+    }
+  }
+  return affine(x, Activation::None);
+}
+
+Tensor Dense::forward_fused(const Tensor &x, Activation act) {
+  CHECK(!training_, "Dense::forward_fused is for inference mode only");
+  CHECK(x.cols == W.rows, "Dense forward mismatch: input "
+                              << x.shape_str() << " expected cols=" << W.rows);
+  return affine(x, act);
+}
+
+Tensor Dense::affine(const Tensor &x, Activation act) {
+  Tensor y;
+  if (precision_ == Precision::BF16) {
+    const uint16_t *xh = x_cache_bf16.data();
+    if (!training_) {
+      scratch_bf16.resize(x.size());
+      f32_to_bf16(x.data.data(), scratch_bf16.data(), x.size());
+      xh = scratch_bf16.data();
+    }
+    if (training_ || !packed_valid_) {
+      pack_b_bf16(W, W_packed_bf16);
+      packed_valid_ = !training_;
+    }
+    matmul_packed_bf16(xh, x.rows, x.cols, W_packed_bf16, b, act, y);
+    return y;
+  }
+
+  // Training mode: W moves every step, so short batches read it in place
+  // rather than paying for a repack; longer ones repack into the reused
+  // buffer. Inference mode packs once.
+  if (training_) {
+    if (x.rows <= kSkinnyRows) {
+      matmul_skinny(x, W, b, act, y);
+      return y;
+    }
+    pack_b(W, W_packed);
+  } else if (!packed_valid_) {
+    pack_b(W, W_packed);
+    packed_valid_ = true;
+  }
+  matmul_packed(x, W_packed, b, act, y);
   return y;
 }
 
 Tensor Dense::backward(const Tensor &grad_out) {
+  CHECK(training_, "Dense::backward called in inference mode");
   CHECK(grad_out.cols == W.cols, "Dense backward mismatch: grad_out "
                                      << grad_out.shape_str()
                                      << " expected cols=" << W.cols);
-  CHECK(grad_out.rows == x_cache.rows,
+  CHECK(grad_out.rows == x_rows,
         "Dense backward mismatch: grad_out "
-            << grad_out.shape_str() << " expected rows=" << x_cache.rows);
+            << grad_out.shape_str() << " expected rows=" << x_rows);
+
+  if (precision_ == Precision::BF16) {
+    // dW = x^T * grad_out, with x^T taken from the half-width cache.
+    scratch_bf16.resize(x_cache_bf16.size());
+    for (int i = 0; i < x_rows; ++i)
+      for (int k = 0; k < x_cols; ++k)
+        scratch_bf16[(size_t)k * x_rows + i] =
+            x_cache_bf16[(size_t)i * x_cols + k];
+    pack_b_bf16(grad_out, scratch_packed_bf16);
+    Tensor dW_cur;
+    matmul_packed_bf16(scratch_bf16.data(), x_cols, x_rows,
+                       scratch_packed_bf16, Tensor(), Activation::None,
+                       dW_cur);
+    accumulate(dW, std::move(dW_cur));
+    accumulate(db, sum_rows(grad_out));
+
+    // dX = grad_out * W^T, with W^T packed straight from W.
+    scratch_bf16.resize(grad_out.size());
+    f32_to_bf16(grad_out.data.data(), scratch_bf16.data(), grad_out.size());
+    pack_bt_bf16(W, scratch_packed_bf16);
+    Tensor dX;
+    matmul_packed_bf16(scratch_bf16.data(), grad_out.rows, grad_out.cols,
+                       scratch_packed_bf16, Tensor(), Activation::None, dX);
+    return dX;
+  }
 
   Tensor Xt = transpose(x_cache);
   Tensor dW_cur = matmul(Xt, grad_out);
-  dW = add(dW, dW_cur);
+  accumulate(dW, std::move(dW_cur));
 
   Tensor db_cur = sum_rows(grad_out);
-  db = add(db, db_cur);
+  accumulate(db, std::move(db_cur));
 
   Tensor Wt = transpose(W);
   Tensor dX = matmul(grad_out, Wt);
@@ -46,7 +130,31 @@ Tensor Dense::backward(const Tensor &grad_out) {
 
 std::vector<NamedParam> Dense::named_parameters() const {
   return {NamedParam{"W", const_cast<Tensor *>(&W), const_cast<Tensor *>(&dW)},
-          NamedParam{"b", const_cast<Tensor *>(&b), const_cast<Tensor *>(&db)}};
+          NamedParam{"b", const_cast<Tensor *>(&b), const_cast<Tensor *>(&db),
+                     /*bias=*/true}};
+}
+
+Module *Dense::clone() const { return new Dense(*this); }
+
+void Dense::set_training(bool training) {
+  training_ = training;
+  packed_valid_ = false;
+  if (!training)
+    x_cache = Tensor();
+}
+
+void Dense::parameters_changed() { packed_valid_ = false; }
+
+void Dense::set_precision(Precision p) {
+  precision_ = p;
+  packed_valid_ = false;
+  x_cache = Tensor();
+  x_cache_bf16.clear();
+  x_cache_bf16.shrink_to_fit();
+  W_packed_bf16 = PackedMatrixBF16();
+  scratch_packed_bf16 = PackedMatrixBF16();
+  scratch_bf16.clear();
+  scratch_bf16.shrink_to_fit();
 }
 
 }  
@@ -0,0 +1,170 @@
+#include "nn/inference.h"
+#include "core/error.h"
+#include "nn/activations.h"
+#include "nn/dense.h"
+#include "nn/sequential.h"
+#include <cstring>
+#include <deque>
+
+namespace tf {
+
+namespace {
+
+const uint32_t kGraphVersion = 1;
+
+struct GraphRecord {
+  uint32_t op;
+  int32_t in;
+  int32_t out;
+};
+
+}  
+
+void export_inference(const Sequential &model, const std::string &path) {
+  std::vector<uint32_t> graph = {kGraphVersion, 0};
+  std::deque<PackedMatrix> packed;
+  std::vector<CheckpointSource> sources;
+  int width = -1;
+
+  const auto &modules = model.modules();
+  for (size_t i = 0; i < modules.size(); ++i) {
+    GraphRecord rec;
+    if (dynamic_cast<const Dense *>(modules[i])) {
+      auto ps = modules[i]->named_parameters();
+      const Tensor &W = *ps[0].value;
+      const Tensor &b = *ps[1].value;
+      CHECK(width < 0 || width == W.rows,
+            "Layer " << i << " expects " << W.rows << " inputs, got "
+                     << width);
+      packed.emplace_back();
+      pack_b(W, packed.back());
+      const std::string prefix = std::to_string(i) + ".";
+      sources.push_back({prefix + "W#packed", DType::F32,
+                         packed.back().panels() * W.rows, kGemmPanel,
+                         packed.back().data.data()});
+      sources.push_back({prefix + "b", DType::F32, 1, b.cols, b.data.data()});
+      rec = {0, W.rows, W.cols};
+      width = W.cols;
+    } else if (dynamic_cast<const ReLU *>(modules[i])) {
+      rec = {1, width, width};
+    } else if (dynamic_cast<const Sigmoid *>(modules[i])) {
+      rec = {2, width, width};
+    } else {
+      THROW_ERROR("export_inference: layer " << i
+                                             << " is not Dense, ReLU or Sigmoid");
+    }
+    CHECK(rec.op == 0 || width >= 0,
+          "export_inference: model must start with a Dense layer");
+    const uint32_t *words = reinterpret_cast<const uint32_t *>(&rec);
+    graph.insert(graph.end(), words, words + 3);
+    ++graph[1];
+  }
+
+  sources.push_back({"#graph", DType::U8, 1,
+                     (int)(graph.size() * sizeof(uint32_t)), graph.data()});
+  save_checkpoint_entries(sources, path);
+}
+
+InferenceModel::InferenceModel(const std::string &path, bool verify)
+    : reader_(path, verify) {
+  const CheckpointEntry *g = reader_.find("#graph");
+  CHECK(g && g->nbytes >= 2 * sizeof(uint32_t),
+        "Not an inference bundle: " << path);
+  const uint32_t *words = static_cast<const uint32_t *>(reader_.payload(*g));
+  CHECK(words[0] == kGraphVersion,
+        "Unsupported inference bundle version: " << words[0]);
+  const uint32_t count = words[1];
+  CHECK(g->nbytes == (2 + 3 * (size_t)count) * sizeof(uint32_t),
+        "Corrupt inference graph in " << path);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    GraphRecord rec;
+    std::memcpy(&rec, words + 2 + 3 * i, sizeof(rec));
+    CHECK(rec.op <= 2 && rec.in > 0 && rec.out > 0,
+          "Corrupt inference graph in " << path);
+    Layer layer;
+    layer.op = (Op)rec.op;
+    layer.in = rec.in;
+    layer.out = rec.out;
+    CHECK(layers_.empty() || layers_.back().out == rec.in,
+          "Inference graph shape mismatch at layer " << i);
+
+    if (layer.op == Op::Dense) {
+      const std::string prefix = std::to_string(i) + ".";
+      const CheckpointEntry *w = reader_.find(prefix + "W#packed");
+      const CheckpointEntry *b = reader_.find(prefix + "b");
+      CHECK(w && b && w->dtype == DType::F32 && b->dtype == DType::F32,
+            "Missing weights for layer " << i << " in " << path);
+      const size_t n = PackedMatrix::packed_size(rec.in, rec.out);
+      // The shape records the panel width: different widths can give the
+      // same byte count but a different layout.
+      const int64_t panels = ((int64_t)rec.out + kGemmPanel - 1) / kGemmPanel;
+      CHECK(w->cols == kGemmPanel && w->rows == panels * rec.in,
+            "Packed weights for layer " << i << " in " << path
+                                        << " use a different panel width");
+      CHECK(w->nbytes == n * sizeof(float) &&
+                b->nbytes == (size_t)rec.out * sizeof(float),
+            "Weight size mismatch for layer " << i << " in " << path);
+      layer.W.rows = rec.in;
+      layer.W.cols = rec.out;
+      layer.W.data =
+          Storage::view(static_cast<float *>(reader_.mutable_payload(*w)), n);
+      layer.b = Tensor::view(static_cast<float *>(reader_.mutable_payload(*b)),
+                             1, rec.out);
+    }
+    layers_.push_back(std::move(layer));
+  }
+  CHECK(!layers_.empty(), "Inference bundle has no layers: " << path);
+}
+
+int InferenceModel::in_features() const { return layers_.front().in; }
+
+int InferenceModel::out_features() const { return layers_.back().out; }
+
+Tensor InferenceModel::forward(const Tensor &x) const {
+  CHECK(x.cols == in_features(), "InferenceModel input "
+                                     << x.shape_str() << " expected cols="
+                                     << in_features());
+  Tensor cur, next;
+  const Tensor *in = &x;
+  for (size_t i = 0; i < layers_.size(); ++i) {
+    const Layer &l = layers_[i];
+    switch (l.op) {
+    case Op::Dense: {
+      // A following activation runs in the GEMM epilogue.
+      Activation act = Activation::None;
+      if (i + 1 < layers_.size()) {
+        if (layers_[i + 1].op == Op::ReLU)
+          act = Activation::ReLU;
+        else if (layers_[i + 1].op == Op::Sigmoid)
+          act = Activation::Sigmoid;
+      }
+      matmul_packed(*in, l.W, l.b, act, next);
+      std::swap(cur, next);
+      in = &cur;
+      if (act != Activation::None)
+        ++i;
+      break;
+    }
+    case Op::ReLU:
+      if (in != &cur) {
+        cur = *in;
+        in = &cur;
+      }
+      relu_(cur);
+      break;
+    case Op::Sigmoid:
+      if (in != &cur) {
+        cur = *in;
+        in = &cur;
+      }
+      sigmoid_(cur);
+      break;
+    }
+  }
+  if (in != &cur)
+    return *in;
+  return cur;
+}
+
+}  
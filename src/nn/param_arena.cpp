@@ -0,0 +1,65 @@
+#include "nn/param_arena.h"
+#include "core/error.h"
+#include "core/storage.h"
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace tf {
+
+static const size_t kAlignFloats = Storage::kAlignment / sizeof(float);
+
+ParamArena::ParamArena(Module &model) : params_(model.params()) {
+  size_t total = 0;
+  for (const auto &p : params_) {
+    CHECK(p.value && p.grad, "ParamArena requires value and grad tensors");
+    CHECK(p.value->size() == p.grad->size(),
+          "ParamArena value/grad size mismatch: " << p.value->shape_str()
+                                                  << " vs "
+                                                  << p.grad->shape_str());
+    offsets_.push_back(total);
+    total += (p.value->size() + kAlignFloats - 1) / kAlignFloats * kAlignFloats;
+  }
+
+  // The flat params are a 1 x total tensor with int dimensions.
+  CHECK(total <= (size_t)INT_MAX,
+        "ParamArena: " << total << " floats exceed a single tensor");
+  values_ = Tensor(1, (int)total, 0.0f);
+  grads_ = Tensor(1, (int)total, 0.0f);
+
+  for (size_t i = 0; i < params_.size(); ++i) {
+    Tensor &v = *params_[i].value;
+    Tensor &g = *params_[i].grad;
+    float *vp = values_.data.data() + offsets_[i];
+    float *gp = grads_.data.data() + offsets_[i];
+    std::memcpy(vp, v.data.data(), v.size() * sizeof(float));
+    std::memcpy(gp, g.data.data(), g.size() * sizeof(float));
+    v.rebind(Tensor::view(vp, v.rows, v.cols));
+    g.rebind(Tensor::view(gp, g.rows, g.cols));
+  }
+}
+
+ParamArena::~ParamArena() {
+  for (auto &p : params_) {
+    Tensor v = *p.value;
+    Tensor g = *p.grad;
+    p.value->rebind(std::move(v));
+    p.grad->rebind(std::move(g));
+  }
+}
+
+void ParamArena::zero_grad() {
+  std::memset(grads_.data.data(), 0, grads_.size() * sizeof(float));
+}
+
+float ParamArena::grad_norm() const {
+  const float *g = grads_.data.data();
+  const long n = (long)grads_.size();
+  double acc = 0.0;
+#pragma omp parallel for simd reduction(+ : acc) schedule(static)
+  for (long i = 0; i < n; ++i)
+    acc += (double)g[i] * (double)g[i];
+  return (float)std::sqrt(acc);
+}
+
+}  
@@ -1,10 +1,16 @@
 #include "nn/sequential.h"
 
 #include "io/checkpoint.h"
+#include "nn/activations.h"
+#include "nn/dense.h"
 
 namespace tf {
 
-void Sequential::add(Module *m) { modules_.push_back(m); }
+void Sequential::add(Module *m) {
+  m->set_training(training_);
+  modules_.push_back(m);
+  module_params_.clear();
+}
 
 Sequential::~Sequential() {
   for (auto *m : modules_) {
@@ -15,6 +21,20 @@ Sequential::~Sequential() {
 Tensor Sequential::forward(const Tensor &x) {
   Tensor out = x;
   for (size_t i = 0; i < modules_.size(); ++i) {
+    if (!training_ && i + 1 < modules_.size()) {
+      if (auto *dense = dynamic_cast<Dense *>(modules_[i])) {
+        Activation act = Activation::None;
+        if (dynamic_cast<ReLU *>(modules_[i + 1]))
+          act = Activation::ReLU;
+        else if (dynamic_cast<Sigmoid *>(modules_[i + 1]))
+          act = Activation::Sigmoid;
+        if (act != Activation::None) {
+          out = dense->forward_fused(out, act);
+          ++i;
+          continue;
+        }
+      }
+    }
     out = modules_[i]->forward(out);
   }
   return out;
@@ -28,6 +48,30 @@ Tensor Sequential::backward(const Tensor &grad_out) {
   return grad;
 }
 
+Tensor Sequential::backward(const Tensor &grad_out,
+                            const GradsReadyFn &on_grads_ready) {
+  if (module_params_.size() != modules_.size()) {
+    module_params_.clear();
+    for (auto *m : modules_)
+      module_params_.push_back(m->params());
+  }
+
+  Tensor grad = grad_out;
+  for (int i = (int)modules_.size() - 1; i >= 0; --i) {
+    grad = modules_[i]->backward(grad);
+    if (!module_params_[i].empty())
+      on_grads_ready(module_params_[i]);
+  }
+  return grad;
+}
+
+void Sequential::release_grads(const std::vector<Param> &ps) {
+  for (const auto &p : ps) {
+    if (p.grad && !p.grad->is_view())
+      *p.grad = Tensor();
+  }
+}
+
 std::vector<NamedParam> Sequential::named_parameters() const {
   std::vector<NamedParam> out;
   for (size_t i = 0; i < modules_.size(); ++i) {
@@ -37,12 +81,44 @@ std::vector<NamedParam> Sequential::named_parameters() const {
       np.name = std::to_string(i) + "." + p.name;
       np.value = p.value;
       np.grad = p.grad;
+      np.bias = p.bias;
       out.push_back(np);
     }
   }
   return out;
 }
 
+Module *Sequential::clone() const {
+  Sequential *copy = new Sequential();
+  copy->training_ = training_; // add() switches each child to this mode
+  try {
+    for (auto *m : modules_) {
+      copy->add(m->clone());
+    }
+  } catch (...) {
+    delete copy;
+    throw;
+  }
+  return copy;
+}
+
+void Sequential::set_precision(Precision p) {
+  for (auto *m : modules_) {
+    m->set_precision(p);
+  }
+}
+
+void Sequential::set_training(bool training) {
+  training_ = training;
+  for (auto *m : modules_)
+    m->set_training(training);
+}
+
+void Sequential::parameters_changed() {
+  for (auto *m : modules_)
+    m->parameters_changed();
+}
+
 void Sequential::save(const std::string &path) { save_checkpoint(*this, path); }
 
 void Sequential::load(const std::string &path) { load_checkpoint(*this, path); }
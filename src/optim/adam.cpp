@@ -1,4 +1,7 @@
 #include "optim/adam.h"
+#include "core/error.h"
+#include "io/training_state.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -12,51 +15,107 @@ void Adam::zero_grad(const std::vector<Param> &ps) {
   }
 }
 
-void Adam::step(const std::vector<Param> &ps) {
-  t_++;
+// Fused moment update + parameter step over one contiguous range. The bias
+// corrections are folded into step_size and inv_sqrt_c2 by the caller, so
+// the loop has no per-element division by them and vectorizes cleanly.
+template <bool kZeroGrad>
+static void adam_kernel(float *__restrict p, float *__restrict g,
+                        float *__restrict m, float *__restrict v, size_t n,
+                        float beta1, float beta2, float step_size,
+                        float inv_sqrt_c2, float eps, float decay) {
+  const float one_minus_b1 = 1.0f - beta1;
+  const float one_minus_b2 = 1.0f - beta2;
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i) {
+    const float gi = g[i];
+    const float mi = beta1 * m[i] + one_minus_b1 * gi;
+    const float vi = beta2 * v[i] + one_minus_b2 * gi * gi;
+    m[i] = mi;
+    v[i] = vi;
+    p[i] = p[i] * decay - step_size * mi / (std::sqrt(vi) * inv_sqrt_c2 + eps);
+    if (kZeroGrad)
+      g[i] = 0.0f;
+  }
+}
 
+void Adam::step(const std::vector<Param> &ps, bool zero_grad) {
+  begin_step();
+  update(ps, zero_grad);
+}
 
-  float correction1 = 1.0f - std::pow(beta1_, t_);
-  float correction2 = 1.0f - std::pow(beta2_, t_);
+void Adam::begin_step() { t_++; }
 
-  for (const auto &p : ps) {
-    if (!p.grad || !p.value)
-      continue;
+void Adam::update(const std::vector<Param> &ps, bool zero_grad) {
+  CHECK(t_ > 0, "Adam::update() called before begin_step()");
 
-    Tensor *param = p.value;
-    Tensor *grad = p.grad;
-
-    if (m_.find(param) == m_.end()) {
-      m_[param] = Tensor(param->rows, param->cols, 0.0f);
-      v_[param] = Tensor(param->rows, param->cols, 0.0f);
-    }
+  if (slots_.bind(ps)) {
+    m_.resize(slots_.total());
+    v_.resize(slots_.total());
+  }
 
-    Tensor &m = m_[param];
-    Tensor &v = v_[param];
+  const float correction1 = 1.0f - std::pow(beta1_, t_);
+  const float correction2 = 1.0f - std::pow(beta2_, t_);
+  const float step_size = lr_ / correction1;
+  const float inv_sqrt_c2 = 1.0f / std::sqrt(correction2);
+  const float decay = 1.0f - lr_ * weight_decay_;
+
+  const auto &chunks = slots_.chunks();
+  const long num_chunks = (long)chunks.size();
+
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+  for (long c = 0; c < num_chunks; ++c) {
+    const ParamSlots::Chunk &ch = chunks[c];
+    const size_t off = slots_.offset(ch.param) + ch.begin;
+    float *p = ps[ch.param].value->data.data() + ch.begin;
+    float *g = ps[ch.param].grad->data.data() + ch.begin;
+    const size_t n = ch.end - ch.begin;
+    if (zero_grad)
+      adam_kernel<true>(p, g, m_.data() + off, v_.data() + off, n, beta1_,
+                        beta2_, step_size, inv_sqrt_c2, eps_, decay);
+    else
+      adam_kernel<false>(p, g, m_.data() + off, v_.data() + off, n, beta1_,
+                         beta2_, step_size, inv_sqrt_c2, eps_, decay);
+  }
+}
 
-    
-    if (grad->rows != param->rows || grad->cols != param->cols)
+void Adam::export_state(const std::vector<NamedParam> &ps, TrainingState &out,
+                        const std::string &prefix) const {
+  out.put_value(prefix + "t", (int32_t)t_);
+  for (const auto &p : ps) {
+    const size_t off = slots_.find(p.value);
+    if (off == ParamSlots::npos)
       continue;
+    out.put(prefix + "m/" + p.name, m_.data() + off, p.value->rows,
+            p.value->cols);
+    out.put(prefix + "v/" + p.name, v_.data() + off, p.value->rows,
+            p.value->cols);
+  }
+}
 
-    size_t len = param->size();
-    float *p_data = param->data.data();
-    const float *g_data = grad->data.data();
-    float *m_data = m.data.data();
-    float *v_data = v.data.data();
-
-    for (size_t i = 0; i < len; ++i) {
-      float g = g_data[i];
-
-      
-      m_data[i] = beta1_ * m_data[i] + (1.0f - beta1_) * g;
-
-      
-      v_data[i] = beta2_ * v_data[i] + (1.0f - beta2_) * g * g;
+void Adam::import_state(const std::vector<NamedParam> &ps,
+                        const TrainingState &in, const std::string &prefix) {
+  t_ = in.value<int32_t>(prefix + "t");
 
-      float m_hat = m_data[i] / correction1;
-      float v_hat = v_data[i] / correction2;
+  std::vector<Param> plain;
+  for (const auto &p : ps)
+    plain.push_back({p.value, p.grad});
+  if (slots_.bind(plain)) {
+    m_.resize(slots_.total());
+    v_.resize(slots_.total());
+  }
 
-      p_data[i] -= lr_ * m_hat / (std::sqrt(v_hat) + eps_);
+  for (size_t i = 0; i < ps.size(); ++i) {
+    const size_t off = slots_.offset(i);
+    if (off == ParamSlots::npos)
+      continue;
+    const Tensor &t = *ps[i].value;
+    const std::string m_name = prefix + "m/" + ps[i].name;
+    if (in.contains(m_name)) {
+      in.get(m_name, m_.data() + off, t.rows, t.cols);
+      in.get(prefix + "v/" + ps[i].name, v_.data() + off, t.rows, t.cols);
+    } else {
+      std::fill(m_.data() + off, m_.data() + off + t.size(), 0.0f);
+      std::fill(v_.data() + off, v_.data() + off + t.size(), 0.0f);
     }
   }
 }
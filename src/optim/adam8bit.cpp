@@ -0,0 +1,127 @@
+#include "optim/adam8bit.h"
+#include "core/error.h"
+#include <algorithm>
+#include <cmath>
+
+namespace tf {
+
+void Adam8bit::zero_grad(const std::vector<Param> &ps) {
+  for (const auto &p : ps) {
+    if (p.grad)
+      p.grad->fill_(0.0f);
+  }
+}
+
+void Adam8bit::step(const std::vector<Param> &ps, bool zero_grad) {
+  begin_step();
+  update(ps, zero_grad);
+}
+
+void Adam8bit::begin_step() { t_++; }
+
+size_t Adam8bit::state_bytes() const {
+  return m_q_.size() * sizeof(int8_t) + v_q_.size() * sizeof(uint8_t) +
+         (m_scale_.size() + v_scale_.size()) * sizeof(float);
+}
+
+struct Adam8bitCoeffs {
+  float beta1;
+  float beta2;
+  float step_size;
+  float inv_sqrt_c2;
+  float eps;
+  float decay;
+};
+
+// Dequantize -> Adam update -> requantize for one block of n <= kBlock
+// elements. The fp32 moments only exist in the two stack buffers.
+static void adam8bit_block(float *__restrict p, float *__restrict g,
+                           int8_t *__restrict mq, uint8_t *__restrict vq,
+                           float &m_scale, float &v_scale, size_t n,
+                           const Adam8bitCoeffs &c, bool zero_grad) {
+  float m[Adam8bit::kBlock];
+  float s[Adam8bit::kBlock]; // sqrt(v)
+
+  const float m_deq = m_scale / (127.0f * 127.0f);
+  const float v_deq = v_scale / (255.0f * 255.0f);
+
+  float m_max = 0.0f, s_max = 0.0f;
+#pragma omp simd reduction(max : m_max, s_max)
+  for (size_t i = 0; i < n; ++i) {
+    const float qm = (float)mq[i];
+    const float qv = (float)vq[i];
+    const float sv = qv * qv * v_deq;
+
+    const float gi = g[i];
+    const float mi = c.beta1 * (qm * std::fabs(qm) * m_deq) +
+                     (1.0f - c.beta1) * gi;
+    const float vi = c.beta2 * (sv * sv) + (1.0f - c.beta2) * gi * gi;
+    const float si = std::sqrt(vi);
+
+    p[i] = p[i] * c.decay - c.step_size * mi / (si * c.inv_sqrt_c2 + c.eps);
+
+    m[i] = mi;
+    s[i] = si;
+    m_max = std::max(m_max, std::fabs(mi));
+    s_max = std::max(s_max, si);
+  }
+
+  // sqrt(v) is rounded up, never down: an element whose second moment
+  // quantized to zero while its first moment did not would otherwise take
+  // a step of m / eps.
+  const float m_q = m_max > 0.0f ? 127.0f / std::sqrt(m_max) : 0.0f;
+  const float s_q = s_max > 0.0f ? 1.0f / s_max : 0.0f;
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i) {
+    const float code = std::sqrt(std::fabs(m[i])) * m_q;
+    const float rounded = std::floor(code + 0.5f);
+    mq[i] = (int8_t)(m[i] < 0.0f ? -rounded : rounded);
+    const float vcode = std::ceil(std::sqrt(s[i] * s_q) * 255.0f);
+    vq[i] = (uint8_t)std::min(vcode, 255.0f);
+  }
+  m_scale = m_max;
+  v_scale = s_max;
+
+  if (zero_grad)
+    std::fill(g, g + n, 0.0f);
+}
+
+void Adam8bit::update(const std::vector<Param> &ps, bool zero_grad) {
+  CHECK(t_ > 0, "Adam8bit::update() called before begin_step()");
+
+  if (slots_.bind(ps)) {
+    m_q_.resize(slots_.total(), 0);
+    v_q_.resize(slots_.total(), 0);
+    m_scale_.resize(slots_.total() / kBlock, 0.0f);
+    v_scale_.resize(slots_.total() / kBlock, 0.0f);
+  }
+
+  Adam8bitCoeffs c;
+  c.beta1 = beta1_;
+  c.beta2 = beta2_;
+  c.step_size = lr_ / (1.0f - std::pow(beta1_, t_));
+  c.inv_sqrt_c2 = 1.0f / std::sqrt(1.0f - std::pow(beta2_, t_));
+  c.eps = eps_;
+  c.decay = 1.0f - lr_ * weight_decay_;
+
+  const auto &chunks = slots_.chunks();
+  const long num_chunks = (long)chunks.size();
+
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+  for (long k = 0; k < num_chunks; ++k) {
+    const ParamSlots::Chunk &ch = chunks[k];
+    float *p = ps[ch.param].value->data.data();
+    float *g = ps[ch.param].grad->data.data();
+    const size_t base = slots_.offset(ch.param);
+
+    for (size_t b = ch.begin; b < ch.end; b += kBlock) {
+      const size_t n = std::min(kBlock, ch.end - b);
+      const size_t at = base + b;
+      adam8bit_block(p + b, g + b, m_q_.data() + at, v_q_.data() + at,
+                     m_scale_[at / kBlock], v_scale_[at / kBlock], n, c,
+                     zero_grad);
+    }
+  }
+}
+
+}  
@@ -0,0 +1,127 @@
+#include "optim/lamb.h"
+#include "core/error.h"
+#include <cmath>
+
+namespace tf {
+
+void LAMB::zero_grad(const std::vector<Param> &ps) {
+  for (const auto &p : ps) {
+    if (p.grad)
+      p.grad->fill_(0.0f);
+  }
+}
+
+void LAMB::step(const std::vector<Param> &ps, bool zero_grad) {
+  begin_step();
+  update(ps, zero_grad);
+}
+
+void LAMB::begin_step() { t_++; }
+
+struct LambCoeffs {
+  float beta1;
+  float beta2;
+  float inv_c1;
+  float inv_sqrt_c2;
+  float eps;
+  float wd;
+};
+
+// Pass 1: moment update fused with the ||w||^2 and ||r||^2 reductions.
+template <bool kZeroGrad>
+static void lamb_moments(const float *__restrict p, float *__restrict g,
+                         float *__restrict m, float *__restrict v, size_t n,
+                         const LambCoeffs &c, double &w2_out, double &r2_out) {
+  double w2 = 0.0, r2 = 0.0;
+#pragma omp simd reduction(+ : w2, r2)
+  for (size_t i = 0; i < n; ++i) {
+    const float gi = g[i];
+    const float mi = c.beta1 * m[i] + (1.0f - c.beta1) * gi;
+    const float vi = c.beta2 * v[i] + (1.0f - c.beta2) * gi * gi;
+    m[i] = mi;
+    v[i] = vi;
+    const float r =
+        mi * c.inv_c1 / (std::sqrt(vi) * c.inv_sqrt_c2 + c.eps) + c.wd * p[i];
+    w2 += (double)p[i] * p[i];
+    r2 += (double)r * r;
+    if (kZeroGrad)
+      g[i] = 0.0f;
+  }
+  w2_out = w2;
+  r2_out = r2;
+}
+
+// Pass 2: w -= lr * trust * r, with r recomputed from the moments.
+static void lamb_apply(float *__restrict p, const float *__restrict m,
+                       const float *__restrict v, size_t n,
+                       const LambCoeffs &c, float scale) {
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i) {
+    const float r =
+        m[i] * c.inv_c1 / (std::sqrt(v[i]) * c.inv_sqrt_c2 + c.eps) +
+        c.wd * p[i];
+    p[i] -= scale * r;
+  }
+}
+
+void LAMB::update(const std::vector<Param> &ps, bool zero_grad) {
+  CHECK(t_ > 0, "LAMB::update() called before begin_step()");
+
+  if (slots_.bind(ps)) {
+    m_.resize(slots_.total());
+    v_.resize(slots_.total());
+  }
+
+  LambCoeffs c;
+  c.beta1 = beta1_;
+  c.beta2 = beta2_;
+  c.inv_c1 = 1.0f / (1.0f - std::pow(beta1_, t_));
+  c.inv_sqrt_c2 = 1.0f / std::sqrt(1.0f - std::pow(beta2_, t_));
+  c.eps = eps_;
+  c.wd = weight_decay_;
+
+  const auto &chunks = slots_.chunks();
+  const long num_chunks = (long)chunks.size();
+  chunk_w2_.resize(num_chunks);
+  chunk_r2_.resize(num_chunks);
+
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+  for (long k = 0; k < num_chunks; ++k) {
+    const ParamSlots::Chunk &ch = chunks[k];
+    const size_t off = slots_.offset(ch.param) + ch.begin;
+    const float *p = ps[ch.param].value->data.data() + ch.begin;
+    float *g = ps[ch.param].grad->data.data() + ch.begin;
+    const size_t n = ch.end - ch.begin;
+    if (zero_grad)
+      lamb_moments<true>(p, g, m_.data() + off, v_.data() + off, n, c,
+                         chunk_w2_[k], chunk_r2_[k]);
+    else
+      lamb_moments<false>(p, g, m_.data() + off, v_.data() + off, n, c,
+                          chunk_w2_[k], chunk_r2_[k]);
+  }
+
+  // Chunk partials are combined in chunk order, so the norms do not depend
+  // on the thread count.
+  std::vector<double> w2(ps.size(), 0.0), r2(ps.size(), 0.0);
+  for (long k = 0; k < num_chunks; ++k) {
+    w2[chunks[k].param] += chunk_w2_[k];
+    r2[chunks[k].param] += chunk_r2_[k];
+  }
+  trust_.assign(ps.size(), 1.0f);
+  for (size_t i = 0; i < ps.size(); ++i) {
+    const double wn = std::sqrt(w2[i]), rn = std::sqrt(r2[i]);
+    if (wn > 0.0 && rn > 0.0)
+      trust_[i] = (float)(wn / rn);
+  }
+
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+  for (long k = 0; k < num_chunks; ++k) {
+    const ParamSlots::Chunk &ch = chunks[k];
+    const size_t off = slots_.offset(ch.param) + ch.begin;
+    lamb_apply(ps[ch.param].value->data.data() + ch.begin, m_.data() + off,
+               v_.data() + off, ch.end - ch.begin, c,
+               lr_ * trust_[ch.param]);
+  }
+}
+
+}  
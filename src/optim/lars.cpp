@@ -0,0 +1,85 @@
+#include "optim/lars.h"
+#include <cmath>
+
+namespace tf {
+
+void LARS::zero_grad(const std::vector<Param> &ps) {
+  for (const auto &p : ps) {
+    if (p.grad)
+      p.grad->fill_(0.0f);
+  }
+}
+
+// Pass 1: ||w||^2 and ||g||^2 in one read of both tensors.
+static void lars_norms(const float *__restrict p, const float *__restrict g,
+                       size_t n, double &w2_out, double &g2_out) {
+  double w2 = 0.0, g2 = 0.0;
+#pragma omp simd reduction(+ : w2, g2)
+  for (size_t i = 0; i < n; ++i) {
+    w2 += (double)p[i] * p[i];
+    g2 += (double)g[i] * g[i];
+  }
+  w2_out = w2;
+  g2_out = g2;
+}
+
+// Pass 2: v = mu * v + local_lr * (g + wd * w); w -= v.
+template <bool kZeroGrad>
+static void lars_apply(float *__restrict p, float *__restrict g,
+                       float *__restrict vel, size_t n, float momentum,
+                       float wd, float local_lr) {
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i) {
+    const float vi = momentum * vel[i] + local_lr * (g[i] + wd * p[i]);
+    vel[i] = vi;
+    p[i] -= vi;
+    if (kZeroGrad)
+      g[i] = 0.0f;
+  }
+}
+
+void LARS::step(const std::vector<Param> &ps, bool zero_grad) {
+  if (slots_.bind(ps))
+    velocity_.resize(slots_.total());
+
+  const auto &chunks = slots_.chunks();
+  const long num_chunks = (long)chunks.size();
+  chunk_w2_.resize(num_chunks);
+  chunk_g2_.resize(num_chunks);
+
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+  for (long k = 0; k < num_chunks; ++k) {
+    const ParamSlots::Chunk &ch = chunks[k];
+    lars_norms(ps[ch.param].value->data.data() + ch.begin,
+               ps[ch.param].grad->data.data() + ch.begin, ch.end - ch.begin,
+               chunk_w2_[k], chunk_g2_[k]);
+  }
+
+  std::vector<double> w2(ps.size(), 0.0), g2(ps.size(), 0.0);
+  for (long k = 0; k < num_chunks; ++k) {
+    w2[chunks[k].param] += chunk_w2_[k];
+    g2[chunks[k].param] += chunk_g2_[k];
+  }
+  trust_.assign(ps.size(), 1.0f);
+  for (size_t i = 0; i < ps.size(); ++i) {
+    const double wn = std::sqrt(w2[i]), gn = std::sqrt(g2[i]);
+    if (wn > 0.0 && gn > 0.0)
+      trust_[i] = (float)(eta_ * wn / (gn + weight_decay_ * wn + eps_));
+  }
+
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+  for (long k = 0; k < num_chunks; ++k) {
+    const ParamSlots::Chunk &ch = chunks[k];
+    float *p = ps[ch.param].value->data.data() + ch.begin;
+    float *g = ps[ch.param].grad->data.data() + ch.begin;
+    float *vel = velocity_.data() + slots_.offset(ch.param) + ch.begin;
+    const size_t n = ch.end - ch.begin;
+    const float local_lr = lr_ * trust_[ch.param];
+    if (zero_grad)
+      lars_apply<true>(p, g, vel, n, momentum_, weight_decay_, local_lr);
+    else
+      lars_apply<false>(p, g, vel, n, momentum_, weight_decay_, local_lr);
+  }
+}
+
+}  
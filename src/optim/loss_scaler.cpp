@@ -0,0 +1,46 @@
+#include "optim/loss_scaler.h"
+#include "core/dtype.h"
+#include "core/error.h"
+
+namespace tf {
+
+void LossScaler::scale_grad(Tensor &d_loss) const {
+  for (auto &g : d_loss.data)
+    g *= scale_;
+}
+
+bool LossScaler::unscale(const std::vector<Param> &ps) const {
+  const float inv = 1.0f / scale_;
+  bool finite = true;
+  for (const auto &p : ps) {
+    if (!p.grad)
+      continue;
+    CHECK(!p.value || p.grad->size() == p.value->size(),
+          "LossScaler: gradient " << p.grad->shape_str()
+                                  << " does not match its parameter "
+                                  << p.value->shape_str()
+                                  << " (released by backward_step?)");
+    float *g = p.grad->data.data();
+    const size_t n = p.grad->size();
+    for (size_t i = 0; i < n; ++i) {
+      finite = finite && !is_nonfinite(g[i]);
+      g[i] *= inv;
+    }
+  }
+  return finite;
+}
+
+void LossScaler::update(bool finite) {
+  if (!finite) {
+    scale_ *= backoff_factor_;
+    good_steps_ = 0;
+    skipped_++;
+    return;
+  }
+  if (++good_steps_ >= growth_interval_) {
+    scale_ *= growth_factor_;
+    good_steps_ = 0;
+  }
+}
+
+}  
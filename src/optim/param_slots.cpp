@@ -0,0 +1,100 @@
+#include "optim/param_slots.h"
+#include <algorithm>
+
+namespace tf {
+
+static bool usable(const Param &p) {
+  return p.value && p.grad && p.grad->rows == p.value->rows &&
+         p.grad->cols == p.value->cols;
+}
+
+bool ParamSlots::Binding::matches(const std::vector<Param> &ps) const {
+  if (ps.size() != values.size())
+    return false;
+  for (size_t i = 0; i < ps.size(); ++i) {
+    if (ps[i].value != values[i] || ps[i].grad != grads[i] ||
+        (ps[i].value ? ps[i].value->size() : 0) != sizes[i] ||
+        (ps[i].grad ? ps[i].grad->size() : 0) != grad_sizes[i])
+      return false;
+  }
+  return true;
+}
+
+bool ParamSlots::bind(const std::vector<Param> &ps) {
+  // Lists usually come round in a fixed order (layer by layer, then the
+  // next step), so try the current binding and its successor first.
+  const size_t n = bindings_.size();
+  ++tick_;
+  for (size_t k = 0; k < n; ++k) {
+    const size_t j = (current_ + k) % n;
+    if (bindings_[j].matches(ps)) {
+      current_ = j;
+      bindings_[j].last_used = tick_;
+      return false;
+    }
+  }
+
+  // A list whose tensors were reshaped replaces its stale binding.
+  size_t slot = n;
+  for (size_t j = 0; j < n && slot == n; ++j) {
+    if (bindings_[j].values.size() == ps.size() &&
+        std::equal(ps.begin(), ps.end(), bindings_[j].values.begin(),
+                   [](const Param &p, const Tensor *v) { return p.value == v; }))
+      slot = j;
+  }
+  if (slot == n) {
+    if (n == 1 && bindings_[0].values.empty()) {
+      slot = 0;
+    } else if (n < kMaxBindings) {
+      bindings_.emplace_back();
+    } else {
+      // Cache full: reuse the least recently used binding.
+      slot = 0;
+      for (size_t j = 1; j < n; ++j)
+        if (bindings_[j].last_used < bindings_[slot].last_used)
+          slot = j;
+    }
+  }
+  current_ = slot;
+  const bool grew = make_binding(ps, bindings_[slot]);
+  bindings_[slot].last_used = tick_;
+  return grew;
+}
+
+bool ParamSlots::make_binding(const std::vector<Param> &ps, Binding &b) {
+  bool grew = false;
+  b = Binding();
+  for (size_t i = 0; i < ps.size(); ++i) {
+    const Param &p = ps[i];
+    const size_t n = p.value ? p.value->size() : 0;
+    b.values.push_back(p.value);
+    b.grads.push_back(p.grad);
+    b.sizes.push_back(n);
+    b.grad_sizes.push_back(p.grad ? p.grad->size() : 0);
+
+    if (!usable(p)) {
+      b.offsets.push_back(npos);
+      continue;
+    }
+
+    // A tensor that was reshaped to a larger size gets a fresh slot.
+    auto it = slots_.find(p.value);
+    if (it == slots_.end() || it->second.size < n) {
+      slots_[p.value] = Slot{total_, n};
+      total_ += (n + align_ - 1) / align_ * align_;
+      grew = true;
+    }
+    b.offsets.push_back(slots_[p.value].offset);
+
+    for (size_t begin = 0; begin < n; begin += kChunk)
+      b.chunks.push_back({i, begin, std::min(n, begin + kChunk)});
+  }
+  return grew;
+}
+
+size_t ParamSlots::find(const Tensor *value) const {
+  auto it = slots_.find(value);
+  return it == slots_.end() ? npos : it->second.offset;
+}
+
+}  
@@ -9,12 +9,77 @@ void SGD::zero_grad(const std::vector<Param> &ps) {
   }
 }
 
-void SGD::step(const std::vector<Param> &ps) {
-  for (auto &p : ps) {
-    for (size_t i = 0; i < p.value->size(); ++i) {
-      p.value->data[i] -= lr_ * p.grad->data[i];
+struct SGDCoeffs {
+  float lr;
+  float momentum;
+  float l2;    // coupled weight decay, added to the gradient
+  float decay; // decoupled weight decay, multiplies the value
+};
+
+// One pass over value/grad(/velocity). The flags are template parameters so
+// every variant is a branch-free loop the compiler can vectorize.
+template <bool kMomentum, bool kNesterov, bool kZeroGrad>
+static void sgd_kernel(float *__restrict p, float *__restrict g,
+                       float *__restrict buf, size_t n, SGDCoeffs c) {
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i) {
+    float d = g[i] + c.l2 * p[i];
+    if (kMomentum) {
+      const float b = c.momentum * buf[i] + d;
+      buf[i] = b;
+      d = kNesterov ? d + c.momentum * b : b;
     }
+    p[i] = p[i] * c.decay - c.lr * d;
+    if (kZeroGrad)
+      g[i] = 0.0f;
+  }
+}
+
+template <bool kMomentum, bool kNesterov, bool kZeroGrad>
+static void sgd_apply(const std::vector<Param> &ps, const ParamSlots &slots,
+                      float *velocity, SGDCoeffs c) {
+  const auto &chunks = slots.chunks();
+  const long num_chunks = (long)chunks.size();
+
+#pragma omp parallel for schedule(static) if (num_chunks > 1)
+  for (long k = 0; k < num_chunks; ++k) {
+    const ParamSlots::Chunk &ch = chunks[k];
+    float *buf =
+        kMomentum ? velocity + slots.offset(ch.param) + ch.begin : nullptr;
+    sgd_kernel<kMomentum, kNesterov, kZeroGrad>(
+        ps[ch.param].value->data.data() + ch.begin,
+        ps[ch.param].grad->data.data() + ch.begin, buf, ch.end - ch.begin, c);
+  }
+}
+
+void SGD::step(const std::vector<Param> &ps, bool zero_grad) {
+  const bool momentum = momentum_ != 0.0f;
+  if (slots_.bind(ps) && momentum)
+    velocity_.resize(slots_.total());
+
+  SGDCoeffs c;
+  c.lr = lr_;
+  c.momentum = momentum_;
+  c.l2 = decoupled_ ? 0.0f : weight_decay_;
+  c.decay = decoupled_ ? 1.0f - lr_ * weight_decay_ : 1.0f;
+
+  float *v = velocity_.data();
+  if (!momentum) {
+    if (zero_grad)
+      sgd_apply<false, false, true>(ps, slots_, v, c);
+    else
+      sgd_apply<false, false, false>(ps, slots_, v, c);
+  } else if (nesterov_) {
+    if (zero_grad)
+      sgd_apply<true, true, true>(ps, slots_, v, c);
+    else
+      sgd_apply<true, true, false>(ps, slots_, v, c);
+  } else {
+    if (zero_grad)
+      sgd_apply<true, false, true>(ps, slots_, v, c);
+    else
+      sgd_apply<true, false, false>(ps, slots_, v, c);
   }
 }
 
-}  
\ No newline at end of file
+}  
@@ -20,8 +20,11 @@ void test_error_macro() {
 
 void test_tensor_creation();
 void test_matmul_simple();
+void test_matmul_packed();
+void test_matmul_fused_epilogue();
 void test_transpose();
 void test_add();
+void test_philox_rng();
 void test_dense_grad_check();
 
 void test_bce_stability();
@@ -37,11 +40,43 @@ void test_move_assignment();
 void test_grad_accumulation();
 
 void test_adam_simple();
+void test_adamw_matches_reference();
+void test_sgd_nesterov_fused_zero_grad();
+void test_fused_backward_step();
+void test_param_slots_bindings();
+void test_lamb_lars_trust_ratio();
+void test_adam8bit_tracks_adam();
 
 void test_make_blobs();
 void test_dataloader_batching();
+void test_dataset_get_batch();
+void test_dataloader_prefetch_order();
+void test_dataloader_workers_order();
+void test_binary_dataset_roundtrip();
+void test_dataloader_block_shuffle();
+void test_compact_dataset();
+void test_stream_loader();
+void test_parse_float();
+void test_read_csv();
 
 void test_save_load();
+void test_checkpoint_v2();
+void test_async_checkpoint();
+void test_training_state_resume();
+void test_delta_checkpoint();
+void test_delta_checkpoint_edge_cases();
+void test_checkpoint_storage_dtypes();
+void test_inference_bundle();
+void test_dense_packed_cache();
+void test_fused_inference_forward();
+
+void test_data_parallel_matches_serial();
+
+void test_bf16_round_trip();
+void test_bf16_dense_matches_fp32();
+void test_loss_scaler_skips_overflow();
+
+void test_param_arena_views();
 
 int main() {
   std::cout << "Running tiny-nn tests..." << std::endl;
@@ -51,8 +86,11 @@ int main() {
 
   tf::test::run_test("Tensor creation", test_tensor_creation);
   tf::test::run_test("Matmul simple", test_matmul_simple);
+  tf::test::run_test("Packed-panel matmul", test_matmul_packed);
+  tf::test::run_test("Fused bias/activation GEMM epilogues", test_matmul_fused_epilogue);
   tf::test::run_test("Transpose", test_transpose);
   tf::test::run_test("Add", test_add);
+  tf::test::run_test("Philox RNG", test_philox_rng);
 
   tf::test::run_test("Dense grad check", test_dense_grad_check);
 
@@ -69,11 +107,46 @@ int main() {
   tf::test::run_test("Grad accumulation", test_grad_accumulation);
 
   tf::test::run_test("Adam simple", test_adam_simple);
+  tf::test::run_test("AdamW matches reference", test_adamw_matches_reference);
+  tf::test::run_test("SGD Nesterov fused zero-grad",
+                     test_sgd_nesterov_fused_zero_grad);
+  tf::test::run_test("Fused backward + step", test_fused_backward_step);
+  tf::test::run_test("ParamSlots per-list bindings", test_param_slots_bindings);
+  tf::test::run_test("LAMB/LARS trust ratio", test_lamb_lars_trust_ratio);
+  tf::test::run_test("Adam8bit tracks Adam", test_adam8bit_tracks_adam);
 
   tf::test::run_test("Make blobs", test_make_blobs);
   tf::test::run_test("DataLoader batching", test_dataloader_batching);
+  tf::test::run_test("Dataset get_batch", test_dataset_get_batch);
+  tf::test::run_test("DataLoader prefetch order", test_dataloader_prefetch_order);
+  tf::test::run_test("DataLoader worker order", test_dataloader_workers_order);
+  tf::test::run_test("Binary mmap dataset", test_binary_dataset_roundtrip);
+  tf::test::run_test("DataLoader block shuffle", test_dataloader_block_shuffle);
+  tf::test::run_test("Compact-dtype dataset", test_compact_dataset);
+  tf::test::run_test("Streaming loader", test_stream_loader);
+  tf::test::run_test("Fast float parser", test_parse_float);
+  tf::test::run_test("CSV ingestion", test_read_csv);
 
   tf::test::run_test("Save/Load checkpoint", test_save_load);
+  tf::test::run_test("Checkpoint v2 (indexed, CRC, mmap)", test_checkpoint_v2);
+  tf::test::run_test("Async checkpoint writer", test_async_checkpoint);
+  tf::test::run_test("Training-state resume is bit-exact", test_training_state_resume);
+  tf::test::run_test("Delta checkpoints and compaction", test_delta_checkpoint);
+  tf::test::run_test("Delta checkpoint overwrite and failed write", test_delta_checkpoint_edge_cases);
+  tf::test::run_test("Checkpoint storage dtypes (f16/bf16/int8)", test_checkpoint_storage_dtypes);
+  tf::test::run_test("Inference bundle (packed weights, mmap)", test_inference_bundle);
+  tf::test::run_test("Dense packed-weight cache", test_dense_packed_cache);
+  tf::test::run_test("Fused inference-mode forward", test_fused_inference_forward);
+
+  tf::test::run_test("DataParallel matches serial",
+                     test_data_parallel_matches_serial);
+
+  tf::test::run_test("BF16 round trip", test_bf16_round_trip);
+  tf::test::run_test("BF16 Dense matches FP32", test_bf16_dense_matches_fp32);
+  tf::test::run_test("Loss scaler overflow skip",
+                     test_loss_scaler_skips_overflow);
+
+  tf::test::run_test("Param arena views", test_param_arena_views);
 
   tf::test::print_summary();
   return (tf::test::tests_passed == tf::test::tests_run) ? 0 : 1;
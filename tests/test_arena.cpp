@@ -0,0 +1,92 @@
+#include "core/rng.h"
+#include "nn/activations.h"
+#include "nn/dense.h"
+#include "nn/param_arena.h"
+#include "nn/sequential.h"
+#include "optim/adam.h"
+#include "utils/test_utils.h"
+#include <memory>
+
+using namespace tf;
+
+void test_param_arena_views() {
+  RNG rng(5);
+  Sequential model;
+  model.add(new Dense(3, 5, rng));
+  model.add(new ReLU());
+  model.add(new Dense(5, 2, rng));
+
+  std::unique_ptr<Module> reference(model.clone());
+  auto ref_ps = reference->params();
+
+  {
+    ParamArena arena(model);
+    auto ps = arena.params();
+    ASSERT_EQ(ps.size(), ref_ps.size());
+
+    for (size_t i = 0; i < ps.size(); ++i) {
+      ASSERT_TRUE(ps[i].value->is_view());
+      ASSERT_TRUE(ps[i].value->data.data() == arena.values() + arena.offset(i));
+      ASSERT_EQ(arena.offset(i) % 16, (size_t)0);
+      for (size_t k = 0; k < ps[i].value->size(); ++k)
+        ASSERT_EQ(ps[i].value->data[k], ref_ps[i].value->data[k]);
+    }
+
+    Tensor x(4, 3, 0.5f);
+    Tensor g(4, 2, 0.25f);
+    Adam flat_optim(0.01f), ref_optim(0.01f);
+    for (int step = 0; step < 3; ++step) {
+      arena.zero_grad();
+      ref_optim.zero_grad(ref_ps);
+      model.forward(x);
+      model.backward(g);
+      reference->forward(x);
+      reference->backward(g);
+      flat_optim.step(arena.flat_params());
+      ref_optim.step(ref_ps);
+    }
+
+    for (size_t i = 0; i < ps.size(); ++i)
+      for (size_t k = 0; k < ps[i].value->size(); ++k)
+        ASSERT_NEAR(ps[i].value->data[k], ref_ps[i].value->data[k], 1e-6f);
+
+    // Copy- and move-assigning a parameter write through its arena view.
+    *ps[0].value = *ref_ps[0].value;
+    ASSERT_TRUE(ps[0].value->is_view());
+    ASSERT_TRUE(ps[0].value->data.data() == arena.values() + arena.offset(0));
+    Tensor fresh(ps[0].value->rows, ps[0].value->cols, 0.5f);
+    *ps[0].value = std::move(fresh);
+    ASSERT_TRUE(ps[0].value->is_view());
+    ASSERT_EQ(arena.values()[arena.offset(0)], 0.5f);
+    const int rows = ps[0].value->rows;
+    Tensor wrong(1, 1, 0.0f);
+    bool threw = false;
+    try {
+      *ps[0].value = wrong;
+    } catch (const std::exception &) {
+      threw = true;
+    }
+    ASSERT_TRUE(threw);
+    ASSERT_TRUE(ps[0].value->is_view());
+    ASSERT_EQ(ps[0].value->rows, rows);
+    threw = false;
+    try {
+      *ps[0].value = Tensor(1, 1, 0.0f);
+    } catch (const std::exception &) {
+      threw = true;
+    }
+    ASSERT_TRUE(threw);
+    threw = false;
+    try {
+      ps[0].value->resize(1, 1);
+    } catch (const std::exception &) {
+      threw = true;
+    }
+    ASSERT_TRUE(threw);
+    ASSERT_TRUE(ps[0].value->is_view());
+    ASSERT_EQ(ps[0].value->rows, rows);
+  }
+
+  for (auto &p : model.params())
+    ASSERT_TRUE(!p.value->is_view() && !p.grad->is_view());
+}
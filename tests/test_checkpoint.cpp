@@ -1,10 +1,25 @@
 #include "core/rng.h"
 #include "core/tensor.h"
+#include "data/dataloader.h"
+#include "data/toy_datasets.h"
 #include "io/checkpoint.h"
+#include "io/crc32c.h"
+#include "io/delta_checkpoint.h"
+#include "io/training_state.h"
+#include "nn/activations.h"
 #include "nn/dense.h"
+#include "nn/inference.h"
+#include "nn/losses.h"
 #include "nn/sequential.h"
+#include "optim/adam.h"
 #include "utils/test_utils.h"
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
 
 using namespace tf;
 using namespace tf::test;
@@ -56,3 +71,509 @@ void test_save_load() {
 
   remove(checkpoint_path.c_str());
 }
+
+static void build_ckpt_model(Sequential &model, uint64_t seed) {
+  RNG rng(seed);
+  model.add(new Dense(10, 5, rng));
+  model.add(new Dense(5, 3, rng));
+}
+
+static void expect_same_params(Module &a, Module &b) {
+  auto pa = a.named_parameters();
+  auto pb = b.named_parameters();
+  ASSERT_EQ(pa.size(), pb.size());
+  for (size_t i = 0; i < pa.size(); ++i) {
+    ASSERT_EQ(pa[i].name, pb[i].name);
+    for (size_t k = 0; k < pa[i].value->size(); ++k)
+      ASSERT_EQ(pa[i].value->data[k], pb[i].value->data[k]);
+  }
+}
+
+void test_checkpoint_v2() {
+  // Standard CRC-32C check value.
+  ASSERT_EQ(crc32c("123456789", 9), 0xE3069283u);
+
+  Sequential src;
+  build_ckpt_model(src, 42);
+  const std::string v1 = "test_checkpoint_v1.tnn";
+  const std::string v2 = "test_checkpoint_v2.tnn";
+  save_checkpoint(src, v1, CheckpointFormat::V1);
+  save_checkpoint(src, v2);
+
+  // Both formats load through the same entry point.
+  Sequential a;
+  build_ckpt_model(a, 1);
+  load_checkpoint(a, v1);
+  expect_same_params(src, a);
+  Sequential b;
+  build_ckpt_model(b, 2);
+  load_checkpoint(b, v2);
+  expect_same_params(src, b);
+
+  {
+    CheckpointReader reader(v2);
+    ASSERT_EQ(reader.entries().size(), src.named_parameters().size());
+    for (const auto &e : reader.entries())
+      ASSERT_EQ(e.offset % CheckpointReader::kAlign, 0u);
+
+    // Zero-copy binding: the parameters alias the mapping, and writes to
+    // them stay private to this process.
+    Sequential c;
+    build_ckpt_model(c, 3);
+    reader.bind(c);
+    expect_same_params(src, c);
+    auto pc = c.named_parameters();
+    ASSERT_TRUE(pc[0].value->is_view());
+    pc[0].value->data[0] += 1.0f;
+  }
+  Sequential d;
+  build_ckpt_model(d, 4);
+  load_checkpoint(d, v2);
+  expect_same_params(src, d);
+
+  // A flipped payload byte is caught by the per-tensor CRC.
+  const CheckpointEntry e = CheckpointReader(v2).entries().back();
+  {
+    FILE *f = fopen(v2.c_str(), "r+b");
+    fseek(f, (long)e.offset, SEEK_SET);
+    int c = fgetc(f);
+    fseek(f, (long)e.offset, SEEK_SET);
+    fputc(c ^ 0x40, f);
+    fclose(f);
+  }
+  bool threw = false;
+  try {
+    load_checkpoint(d, v2);
+  } catch (const std::exception &) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+
+  // Negative dims are refused on save, and on load even when their product
+  // matches the payload size and the index checksum is valid.
+  std::vector<float> blob(16, 1.0f);
+  threw = false;
+  try {
+    save_checkpoint_entries({{"t", DType::F32, -2, -8, blob.data()}}, v2);
+  } catch (const std::exception &) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+  save_checkpoint_entries({{"t", DType::F32, 2, 8, blob.data()}}, v2);
+  {
+    std::vector<uint8_t> file;
+    {
+      std::ifstream in(v2, std::ios::binary);
+      file.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    uint64_t index_offset, index_bytes;
+    std::memcpy(&index_offset, file.data() + 16, 8);
+    std::memcpy(&index_bytes, file.data() + 24, 8);
+    const int32_t dims[2] = {-2, -8};
+    // Entry: name length, name "t", dtype, then rows and cols.
+    std::memcpy(file.data() + index_offset + 4 + 1 + 4, dims, sizeof(dims));
+    const uint32_t crc = crc32c(file.data() + index_offset, index_bytes);
+    std::memcpy(file.data() + 12, &crc, 4);
+    std::ofstream out(v2, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(file.data()), file.size());
+  }
+  threw = false;
+  try {
+    CheckpointReader reader(v2);
+  } catch (const std::exception &) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+
+  remove(v1.c_str());
+  remove(v2.c_str());
+}
+
+void test_async_checkpoint() {
+  Sequential model;
+  build_ckpt_model(model, 42);
+  Sequential first;
+  build_ckpt_model(first, 42);
+  const std::string path = "test_checkpoint_async.tnn";
+
+  AsyncCheckpointWriter writer;
+  auto f1 = writer.save(model, path);
+  // The snapshot is taken inside save(), so the model may change right away.
+  for (auto &p : model.named_parameters())
+    for (auto &v : p.value->data)
+      v += 1.0f;
+  f1.get();
+
+  Sequential loaded;
+  build_ckpt_model(loaded, 7);
+  load_checkpoint(loaded, path);
+  expect_same_params(first, loaded);
+
+  // Back-to-back saves to one path land in order; the last one wins.
+  writer.save(first, path);
+  auto f3 = writer.save(model, path);
+  writer.save(model, path).get();
+  f3.get();
+  load_checkpoint(loaded, path);
+  expect_same_params(model, loaded);
+
+  FILE *tmp = fopen((path + ".tmp").c_str(), "rb");
+  ASSERT_TRUE(tmp == nullptr);
+  remove(path.c_str());
+}
+
+// Runs `steps` Adam steps from the loader, starting a new epoch whenever
+// it runs dry.
+static void train_steps(Sequential &model, Adam &optim, DataLoader &loader,
+                        int steps) {
+  auto ps = model.params();
+  Tensor x, y;
+  for (int s = 0; s < steps; ++s) {
+    if (!loader.next(x, y)) {
+      loader.reset();
+      ASSERT_TRUE(loader.next(x, y));
+    }
+    optim.zero_grad(ps);
+    Tensor logits = model.forward(x);
+    Tensor d_logits;
+    softmax_cross_entropy_with_logits(logits, y, d_logits);
+    model.backward(d_logits);
+    optim.step(ps);
+  }
+}
+
+void test_training_state_resume() {
+  TensorDataset data = make_blobs(200, 4, 3, 1.0f, 5);
+  const std::string path = "test_training_state.tnn";
+
+  auto build = [](Sequential &m, uint64_t seed) {
+    RNG rng(seed);
+    m.add(new Dense(4, 16, rng));
+    m.add(new ReLU());
+    m.add(new Dense(16, 3, rng));
+  };
+
+  // Reference run: 10 steps (mid-epoch with 7 batches per epoch), save,
+  // then 12 more steps crossing an epoch boundary.
+  Sequential ref;
+  build(ref, 1);
+  Adam ref_opt(0.01f);
+  DataLoader ref_loader(data, 32, true, 99);
+  train_steps(ref, ref_opt, ref_loader, 10);
+  save_training_state(path, ref, ref_opt, ref_loader, 1);
+  train_steps(ref, ref_opt, ref_loader, 12);
+
+  // Fresh objects with different seeds; the restored loader prefetches.
+  Sequential model;
+  build(model, 2);
+  Adam opt(0.01f);
+  LoaderOptions lo;
+  lo.seed = 7;
+  lo.prefetch = 2;
+  DataLoader loader(data, 32, lo);
+  ASSERT_EQ(load_training_state(path, model, opt, loader), 1);
+  train_steps(model, opt, loader, 12);
+
+  auto pa = ref.named_parameters();
+  auto pb = model.named_parameters();
+  for (size_t i = 0; i < pa.size(); ++i)
+    for (size_t k = 0; k < pa[i].value->size(); ++k)
+      ASSERT_EQ(pa[i].value->data[k], pb[i].value->data[k]);
+
+  // A loader with different shuffle options refuses the state.
+  TrainingState saved(path);
+  LoaderOptions unshuffled;
+  unshuffled.shuffle = false;
+  LoaderOptions blocked;
+  blocked.shuffle_block = 16;
+  for (const LoaderOptions &o : {unshuffled, blocked}) {
+    DataLoader other(data, 32, o);
+    bool threw = false;
+    try {
+      other.import_state(saved);
+    } catch (const std::exception &) {
+      threw = true;
+    }
+    ASSERT_TRUE(threw);
+  }
+
+  remove(path.c_str());
+}
+
+void test_delta_checkpoint() {
+  Sequential model;
+  build_ckpt_model(model, 42);
+  auto ps = model.named_parameters();
+  const std::vector<std::string> paths = {"test_delta_0.tnn", "test_delta_1.tnn",
+                                          "test_delta_2.tnn"};
+
+  DeltaCheckpointWriter writer(/*block_elems=*/16);
+  DeltaStats s0 = writer.save(model, paths[0]);
+  ASSERT_TRUE(s0.full);
+
+  // Touch one element of the first weight only.
+  ps[0].value->data[3] += 1.0f;
+  DeltaStats s1 = writer.save(model, paths[1]);
+  ASSERT_TRUE(!s1.full);
+  ASSERT_EQ(s1.tensors_changed, 1u);
+  ASSERT_EQ(s1.blocks_changed, 1u);
+
+  // Then the whole last layer.
+  for (size_t i = 2; i < ps.size(); ++i)
+    for (auto &v : ps[i].value->data)
+      v += 0.5f;
+  DeltaStats s2 = writer.save(model, paths[2]);
+  ASSERT_EQ(s2.tensors_changed, ps.size() - 2);
+  ASSERT_EQ(checkpoint_chain(paths[2]).size(), 3u);
+
+  Sequential loaded;
+  build_ckpt_model(loaded, 7);
+  load_checkpoint(loaded, paths[2]);
+  expect_same_params(model, loaded);
+
+  // Compaction folds the chain into a standalone full snapshot.
+  const std::string compact = "test_delta_compact.tnn";
+  compact_checkpoint(paths[2], compact);
+  for (const auto &p : paths)
+    remove(p.c_str());
+  Sequential from_compact;
+  build_ckpt_model(from_compact, 8);
+  load_checkpoint(from_compact, compact);
+  expect_same_params(model, from_compact);
+  remove(compact.c_str());
+}
+
+void test_checkpoint_storage_dtypes() {
+  Sequential src;
+  build_ckpt_model(src, 42);
+  const std::string path = "test_checkpoint_dtype.tnn";
+  auto ps = src.named_parameters();
+
+  const DType dtypes[] = {DType::F16, DType::BF16, DType::I8};
+  for (DType dt : dtypes) {
+    CheckpointStorage storage;
+    storage.matrices = dt;
+    save_checkpoint(src, path, storage);
+
+    {
+      CheckpointReader reader(path);
+      ASSERT_TRUE(reader.find(ps[0].name)->dtype == dt);
+      ASSERT_TRUE(reader.find(ps[1].name)->dtype == DType::F32); // bias
+      ASSERT_EQ(reader.find(ps[0].name + "#scale") != nullptr,
+                dt == DType::I8);
+    }
+
+    Sequential dst;
+    build_ckpt_model(dst, 9);
+    load_checkpoint(dst, path);
+    auto pd = dst.named_parameters();
+    for (size_t i = 0; i < ps.size(); ++i) {
+      const Tensor &a = *ps[i].value;
+      const Tensor &b = *pd[i].value;
+      for (int c = 0; c < a.cols; ++c) {
+        float absmax = 0.0f;
+        for (int r = 0; r < a.rows; ++r)
+          absmax = std::max(absmax, std::fabs(a(r, c)));
+        for (int r = 0; r < a.rows; ++r) {
+          float tol = 0.0f;
+          if (!ps[i].bias)
+            tol = dt == DType::F16    ? std::fabs(a(r, c)) * 1e-3f
+                  : dt == DType::BF16 ? std::fabs(a(r, c)) * 4e-3f
+                                      : absmax / 127.0f * 0.5f + 1e-7f;
+          ASSERT_NEAR(a(r, c), b(r, c), tol);
+        }
+      }
+    }
+  }
+
+  // A single-input layer's 1 x N weight is still stored as a matrix.
+  RNG rng(4);
+  Sequential thin;
+  thin.add(new Dense(1, 8, rng));
+  CheckpointStorage i8;
+  i8.matrices = DType::I8;
+  save_checkpoint(thin, path, i8);
+  {
+    CheckpointReader reader(path);
+    auto pt = thin.named_parameters();
+    ASSERT_TRUE(reader.find(pt[0].name)->dtype == DType::I8);
+    ASSERT_TRUE(reader.find(pt[1].name)->dtype == DType::F32);
+  }
+
+  // Non-finite weights fail the i8 save instead of quantizing to garbage.
+  thin.named_parameters()[0].value->data[3] = std::nanf("");
+  bool threw = false;
+  try {
+    save_checkpoint(thin, path, i8);
+  } catch (const std::exception &) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+  remove(path.c_str());
+}
+
+void test_inference_bundle() {
+  RNG rng(11);
+  Sequential model;
+  model.add(new Dense(6, 20, rng));
+  model.add(new ReLU());
+  model.add(new Dense(20, 3, rng));
+  model.add(new Sigmoid());
+  const std::string path = "test_inference.tnn";
+  export_inference(model, path);
+
+  InferenceModel inf(path);
+  ASSERT_EQ(inf.num_layers(), 4u);
+  ASSERT_EQ(inf.in_features(), 6);
+  ASSERT_EQ(inf.out_features(), 3);
+
+  Tensor x(5, 6);
+  for (auto &v : x.data)
+    v = rng.uniform(-2.0f, 2.0f);
+  Tensor expected = model.forward(x);
+  Tensor y = inf.forward(x);
+  ASSERT_EQ(y.rows, 5);
+  ASSERT_EQ(y.cols, 3);
+  for (size_t i = 0; i < y.size(); ++i)
+    ASSERT_NEAR(y.data[i], expected.data[i], 1e-6f);
+
+  // A bundle packed with 8-wide panels has the same byte count for 32
+  // outputs, but not the same layout.
+  const int in = 6, out = 32;
+  std::vector<float> w8((size_t)in * out), b8(out);
+  const uint32_t graph[] = {1, 1, 0, (uint32_t)in, (uint32_t)out};
+  save_checkpoint_entries(
+      {{"0.W#packed", DType::F32, in * out / 8, 8, w8.data()},
+       {"0.b", DType::F32, 1, out, b8.data()},
+       {"#graph", DType::U8, 1, (int)sizeof(graph), graph}},
+      path);
+  bool threw = false;
+  try {
+    InferenceModel bad(path);
+  } catch (const std::exception &) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+
+  remove(path.c_str());
+}
+
+void test_dense_packed_cache() {
+  Sequential model;
+  build_ckpt_model(model, 5);
+  RNG rng(6);
+  Tensor x(4, 10);
+  for (auto &v : x.data)
+    v = rng.uniform(-1.0f, 1.0f);
+  Tensor train_y = model.forward(x);
+
+  // Inference mode reuses W packed on the first forward.
+  model.set_training(false);
+  for (int rep = 0; rep < 2; ++rep) {
+    Tensor y = model.forward(x);
+    for (size_t i = 0; i < y.size(); ++i)
+      ASSERT_EQ(y.data[i], train_y.data[i]);
+  }
+
+  // Loading new weights must drop the cached packing.
+  Sequential other;
+  build_ckpt_model(other, 7);
+  const std::string path = "test_packed_cache.tnn";
+  save_checkpoint(other, path);
+  load_checkpoint(model, path);
+  Tensor expected = other.forward(x);
+  Tensor y = model.forward(x);
+  for (size_t i = 0; i < y.size(); ++i)
+    ASSERT_EQ(y.data[i], expected.data[i]);
+
+  bool threw = false;
+  try {
+    model.backward(y);
+  } catch (const std::exception &) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+  remove(path.c_str());
+}
+
+void test_fused_inference_forward() {
+  RNG rng(12);
+  Sequential model;
+  model.add(new Dense(30, 70, rng));
+  model.add(new ReLU());
+  model.add(new Dense(70, 20, rng));
+  model.add(new Sigmoid());
+  model.add(new Dense(20, 3, rng));
+
+  // Short batches take the skinny kernel in training mode; inference mode
+  // runs the packed kernel with ReLU / Sigmoid in its epilogue.
+  for (int batch : {1, 3, 16, 17}) {
+    Tensor x(batch, 30);
+    for (auto &v : x.data)
+      v = rng.uniform(-1.0f, 1.0f);
+    model.set_training(true);
+    Tensor expected = model.forward(x);
+    model.set_training(false);
+    Tensor y = model.forward(x);
+    ASSERT_EQ(y.rows, batch);
+    ASSERT_EQ(y.cols, 3);
+    for (size_t i = 0; i < y.size(); ++i)
+      ASSERT_NEAR(y.data[i], expected.data[i], 1e-5f);
+  }
+  // Modules added after the switch inherit the model's mode.
+  model.set_training(false);
+  model.add(new ReLU());
+  model.add(new Dense(3, 2, rng));
+  model.add(new Sigmoid());
+  Tensor x(1, 30, 0.25f);
+  Tensor y = model.forward(x);
+  ASSERT_EQ(y.cols, 2);
+
+  // A clone of an inference-mode model is in inference mode throughout.
+  std::unique_ptr<Module> copy(model.clone());
+  Tensor yc = copy->forward(x);
+  ASSERT_EQ(yc.cols, 2);
+  for (size_t i = 0; i < y.size(); ++i)
+    ASSERT_NEAR(yc.data[i], y.data[i], 1e-6f);
+}
+
+void test_delta_checkpoint_edge_cases() {
+  Sequential model;
+  build_ckpt_model(model, 42);
+  auto ps = model.named_parameters();
+
+  // Saving over the previous file must not leave a delta that is its own
+  // parent.
+  const std::string latest = "test_delta_latest.tnn";
+  DeltaCheckpointWriter same(/*block_elems=*/16);
+  ASSERT_TRUE(same.save(model, latest).full);
+  ps[0].value->data[0] += 1.0f;
+  ASSERT_TRUE(same.save(model, latest).full);
+  Sequential a;
+  build_ckpt_model(a, 1);
+  load_checkpoint(a, latest);
+  expect_same_params(model, a);
+  remove(latest.c_str());
+
+  // A failed delta write keeps its blocks for the next delta.
+  const std::string base = "test_delta_base.tnn", next = "test_delta_next.tnn";
+  DeltaCheckpointWriter writer(/*block_elems=*/16);
+  writer.save(model, base);
+  ps[0].value->data[5] += 1.0f;
+  bool threw = false;
+  try {
+    writer.save(model, "no_such_dir/test_delta_failed.tnn");
+  } catch (const std::exception &) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+  DeltaStats s = writer.save(model, next);
+  ASSERT_TRUE(!s.full);
+  ASSERT_EQ(s.blocks_changed, 1u);
+  Sequential b;
+  build_ckpt_model(b, 2);
+  load_checkpoint(b, next);
+  expect_same_params(model, b);
+  remove(base.c_str());
+  remove(next.c_str());
+}
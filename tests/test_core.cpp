@@ -2,6 +2,9 @@
 #include "core/tensor.h"
 #include "core/math.h"
 #include "core/error.h"
+#include "core/rng.h"
+#include <cmath>
+#include <vector>
 
 using namespace tf;
 
@@ -56,6 +59,68 @@ void test_matmul_simple() {
     ASSERT_EQ(C(1, 1), 55.0f);
 }
 
+void test_matmul_packed() {
+    // Shapes with row and column tails around the 4 x 16 kernel block.
+    const int shapes[][3] = {{1, 7, 5}, {3, 16, 16}, {5, 33, 17}, {9, 64, 40}};
+    RNG rng(3);
+    for (const auto& s : shapes) {
+        const int M = s[0], K = s[1], N = s[2];
+        Tensor A(M, K), B(K, N);
+        for (auto& v : A.data) v = rng.uniform(-1.0f, 1.0f);
+        for (auto& v : B.data) v = rng.uniform(-1.0f, 1.0f);
+
+        PackedMatrix Bp;
+        pack_b(B, Bp);
+        ASSERT_EQ(Bp.data.size(), PackedMatrix::packed_size(K, N));
+        Tensor C;
+        matmul_packed(A, Bp, C);
+        ASSERT_EQ(C.rows, M);
+        ASSERT_EQ(C.cols, N);
+        for (int i = 0; i < M; ++i) {
+            for (int j = 0; j < N; ++j) {
+                double ref = 0.0;
+                for (int k = 0; k < K; ++k) ref += (double)A(i, k) * B(k, j);
+                ASSERT_NEAR(C(i, j), ref, 1e-4);
+            }
+        }
+    }
+}
+
+void test_matmul_fused_epilogue() {
+    // Skinny (row-major B) and packed kernels with bias + activation fused,
+    // checked against a reference; N covers full and partial column blocks.
+    const int shapes[][3] = {{1, 9, 10}, {2, 31, 64}, {3, 40, 70}, {6, 17, 130}};
+    const Activation acts[] = {Activation::None, Activation::ReLU, Activation::Sigmoid};
+    RNG rng(4);
+    for (const auto& s : shapes) {
+        const int M = s[0], K = s[1], N = s[2];
+        Tensor A(M, K), B(K, N), bias(1, N);
+        for (auto& v : A.data) v = rng.uniform(-1.0f, 1.0f);
+        for (auto& v : B.data) v = rng.uniform(-1.0f, 1.0f);
+        for (auto& v : bias.data) v = rng.uniform(-1.0f, 1.0f);
+        PackedMatrix Bp;
+        pack_b(B, Bp);
+
+        for (Activation act : acts) {
+            Tensor Cs, Cp;
+            matmul_skinny(A, B, bias, act, Cs);
+            matmul_packed(A, Bp, bias, act, Cp);
+            ASSERT_EQ(Cs.rows, M);
+            ASSERT_EQ(Cs.cols, N);
+            for (int i = 0; i < M; ++i) {
+                for (int j = 0; j < N; ++j) {
+                    double ref = bias(0, j);
+                    for (int k = 0; k < K; ++k) ref += (double)A(i, k) * B(k, j);
+                    if (act == Activation::ReLU) ref = ref > 0.0 ? ref : 0.0;
+                    if (act == Activation::Sigmoid) ref = 1.0 / (1.0 + std::exp(-ref));
+                    ASSERT_NEAR(Cs(i, j), ref, 1e-4);
+                    ASSERT_NEAR(Cp(i, j), ref, 1e-4);
+                }
+            }
+        }
+    }
+}
+
 void test_transpose() {
     Tensor A(2, 3);
     A(0, 0) = 1; A(0, 1) = 2; A(0, 2) = 3;
@@ -79,3 +144,84 @@ void test_add() {
     Tensor C = add(A, B);
     ASSERT_EQ(C(0, 0), 2.0f);
 }
+
+void test_philox_rng() {
+  // Known-answer vectors for Philox4x32-10 from the Random123 distribution.
+  uint32_t out[4];
+  RNG::philox(0, 0, 0, out);
+  ASSERT_EQ(out[0], 0x6627e8d5u);
+  ASSERT_EQ(out[1], 0xe169c58du);
+  ASSERT_EQ(out[2], 0xbc57ac4cu);
+  ASSERT_EQ(out[3], 0x9b00dbd8u);
+  RNG::philox(~0ull, ~0ull, ~0ull, out);
+  ASSERT_EQ(out[0], 0x408f276du);
+  ASSERT_EQ(out[3], 0x6d5451fdu);
+  RNG::philox(0x299f31d0a4093822ull, 0x0370734413198a2eull,
+              0x85a308d3243f6a88ull, out);
+  ASSERT_EQ(out[0], 0xd16cfe09u);
+  ASSERT_EQ(out[1], 0x94fdccebu);
+  ASSERT_EQ(out[2], 0x5001e420u);
+  ASSERT_EQ(out[3], 0x24126ea1u);
+
+  // Bulk fill matches the scalar sequence, whatever the split.
+  const size_t n = 200003;
+  std::vector<float> bulk(n), halves(n);
+  RNG a(99);
+  a.fill_uniform(bulk.data(), n, -2.0f, 3.0f);
+  RNG b(99);
+  b.fill_uniform(halves.data(), 1000, -2.0f, 3.0f);
+  b.fill_uniform(halves.data() + 1000, n - 1000, -2.0f, 3.0f);
+  RNG c(99);
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_EQ(bulk[i], halves[i]);
+    if (i < 4000)
+      ASSERT_NEAR(bulk[i], c.uniform(-2.0f, 3.0f), 1e-6f);
+  }
+  ASSERT_EQ(a.block, b.block);
+
+  // jump() skips exactly the blocks a fill would have used.
+  RNG d(99);
+  d.jump(250);
+  ASSERT_NEAR(d.uniform(-2.0f, 3.0f), bulk[1000], 1e-6f);
+
+  // Normals: rough moments; sub-streams differ from the parent.
+  std::vector<float> z(n);
+  RNG e(7);
+  e.fill_normal(z.data(), n, 1.0f, 2.0f);
+  double mean = 0.0, var = 0.0;
+  for (float v : z)
+    mean += v;
+  mean /= n;
+  for (float v : z)
+    var += (v - mean) * (v - mean);
+  var /= n;
+  ASSERT_NEAR(mean, 1.0, 0.03);
+  ASSERT_NEAR(var, 4.0, 0.1);
+  RNG s1 = e.split(1), s2 = e.split(2);
+  ASSERT_TRUE(s1.next_u32() != s2.next_u32());
+
+  // uniform_int stays in range and hits every value.
+  RNG f(3);
+  std::vector<int> hist(7, 0);
+  for (int i = 0; i < 7000; ++i) {
+    uint32_t v = f.uniform_int(7);
+    ASSERT_TRUE(v < 7);
+    hist[v]++;
+  }
+  for (int h : hist)
+    ASSERT_TRUE(h > 800 && h < 1200);
+
+  // uniform_int64 matches uniform_int on 32-bit ranges and covers ranges
+  // past 2^32, where a truncated bound would never draw the upper half.
+  RNG g(3), h(3);
+  for (int i = 0; i < 100; ++i)
+    ASSERT_EQ(g.uniform_int64(1000), (uint64_t)h.uniform_int(1000));
+  const uint64_t big = (1ull << 33) + 5;
+  bool upper = false;
+  for (int i = 0; i < 200; ++i) {
+    const uint64_t v = g.uniform_int64(big);
+    ASSERT_TRUE(v < big);
+    upper |= v >= (1ull << 32);
+  }
+  ASSERT_TRUE(upper);
+}
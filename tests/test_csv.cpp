@@ -0,0 +1,129 @@
+#include "data/binary_dataset.h"
+#include "data/csv.h"
+#include "utils/test_utils.h"
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+using namespace tf;
+
+void test_parse_float() {
+  const char *cases[] = {"0",        "-0.5",     "3.14159",   "1e10",
+                         "-2.5E-3",  "+7",       ".25",       "1.",
+                         "123456789.123456789",  "1e-40",     "3.4e38",
+                         "0.000001", "00012.50", "9999999999999999999999"};
+  for (const char *s : cases) {
+    const char *end = s + std::strlen(s);
+    float v = 0.0f;
+    const char *stop = parse_float(s, end, v);
+    ASSERT_TRUE(stop == end);
+    const float ref = std::strtof(s, nullptr);
+    ASSERT_NEAR(v, ref, std::fabs(ref) * 1.2e-7f + 1e-45f);
+  }
+
+  float v;
+  const char *bad = "abc";
+  ASSERT_TRUE(parse_float(bad, bad + 3, v) == nullptr);
+  const char *partial = "1.5x";
+  ASSERT_TRUE(parse_float(partial, partial + 4, v) == partial + 3);
+}
+
+void test_read_csv() {
+  const std::string path = "test_data.csv";
+  const std::string bin = "test_data_csv.tnds";
+  const int rows = 500;
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "id, a ,b,label,c\r\n";
+    for (int i = 0; i < rows; ++i) {
+      out << i << ", " << i * 0.5f << "," << -i << "e-2," << i % 3 << ","
+          << i * 1e3f << "\r\n";
+      if (i == 250)
+        out << "\n"; // blank lines are skipped
+    }
+  }
+
+  CsvOptions opts;
+  opts.label_name = "label";
+  opts.feature_names = {"c", "a"};
+  opts.num_classes = 3;
+  // Tiny chunks and several parsers to cross line and chunk boundaries.
+  opts.chunk_bytes = 97;
+  opts.num_threads = 3;
+
+  TensorDataset ds = read_csv(path, opts);
+  ASSERT_EQ(ds.size(), (size_t)rows);
+  const Tensor &x = ds.features();
+  const Tensor &y = ds.targets();
+  ASSERT_EQ(x.cols, 2);
+  ASSERT_EQ(y.cols, 3);
+  for (int i = 0; i < rows; ++i) {
+    ASSERT_NEAR(x(i, 0), i * 1e3f, 1e-3f * i);
+    ASSERT_NEAR(x(i, 1), i * 0.5f, 1e-6f);
+    for (int c = 0; c < 3; ++c)
+      ASSERT_EQ(y(i, c), c == i % 3 ? 1.0f : 0.0f);
+  }
+
+  // Same parse, streamed to the binary format.
+  ASSERT_EQ(csv_to_binary(path, bin, opts), (size_t)rows);
+  MmapDataset mm(bin);
+  ASSERT_EQ(mm.size(), (size_t)rows);
+  for (size_t i = 0; i < mm.size(); i += 37) {
+    Sample s = mm.get(i);
+    ASSERT_EQ(s.x(0, 0), x((int)i, 0));
+    ASSERT_EQ(s.y(0, 1), y((int)i, 1));
+  }
+
+  // Regression target by index, all other columns as features.
+  CsvOptions reg;
+  reg.label_column = 2;
+  TensorDataset r = read_csv(path, reg);
+  ASSERT_EQ(r.features().cols, 4);
+  ASSERT_EQ(r.targets().cols, 1);
+  ASSERT_NEAR(r.targets()(10, 0), -0.1f, 1e-7f);
+
+  // Malformed field.
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "1,2,3\n4,oops,6\n";
+  }
+  CsvOptions plain;
+  plain.has_header = false;
+  bool threw = false;
+  try {
+    read_csv(path, plain);
+  } catch (const std::exception &) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+
+  // Class labels outside [0, num_classes), fractional or too large to fit
+  // an int are rejected rather than converted.
+  CsvOptions cls;
+  cls.has_header = false;
+  cls.label_column = 1;
+  cls.num_classes = 3;
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "0.5,1\n0.25,2\n";
+  }
+  ASSERT_EQ(read_csv(path, cls).targets()(1, 2), 1.0f);
+  for (const char *label : {"1e20", "1e39", "-1", "3", "1.5"}) {
+    {
+      std::ofstream out(path, std::ios::binary);
+      out << "0.5,1\n0.25," << label << "\n";
+    }
+    threw = false;
+    try {
+      read_csv(path, cls);
+    } catch (const std::exception &) {
+      threw = true;
+    }
+    ASSERT_TRUE(threw);
+  }
+
+  std::remove(path.c_str());
+  std::remove(bin.c_str());
+}
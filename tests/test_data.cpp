@@ -1,6 +1,12 @@
+#include "data/binary_dataset.h"
+#include "data/compact_dataset.h"
 #include "data/dataloader.h"
+#include "data/iterable_dataset.h"
 #include "data/toy_datasets.h"
 #include "utils/test_utils.h"
+#include <algorithm>
+#include <mutex>
+#include <sstream>
 
 using namespace tf;
 
@@ -54,3 +60,390 @@ void test_dataloader_batching() {
   ASSERT_TRUE(loader.next(X, Y));
   ASSERT_EQ(X.rows, 3);
 }
+
+namespace {
+
+// Forwards get() only, so get_batch falls back to the per-sample default.
+struct PerSampleDataset : Dataset {
+  const Dataset &inner;
+  explicit PerSampleDataset(const Dataset &d) : inner(d) {}
+  size_t size() const override { return inner.size(); }
+  Sample get(size_t i) const override { return inner.get(i); }
+};
+
+}  
+
+void test_dataset_get_batch() {
+  auto ds = make_blobs(40, 3, 4);
+  PerSampleDataset slow(ds);
+  const size_t idx[] = {7, 0, 39, 12, 12};
+
+  Tensor X, Y, X2, Y2;
+  ds.get_batch(idx, 5, X, Y);
+  slow.get_batch(idx, 5, X2, Y2);
+  ASSERT_EQ(X.rows, 5);
+  ASSERT_EQ(X.cols, 3);
+  ASSERT_EQ(Y.cols, 4);
+  for (int k = 0; k < 5; ++k) {
+    Sample s = ds.get(idx[k]);
+    for (int j = 0; j < X.cols; ++j) {
+      ASSERT_EQ(X(k, j), s.x(0, j));
+      ASSERT_EQ(X2(k, j), s.x(0, j));
+    }
+    for (int j = 0; j < Y.cols; ++j) {
+      ASSERT_EQ(Y(k, j), s.y(0, j));
+      ASSERT_EQ(Y2(k, j), s.y(0, j));
+    }
+  }
+
+  // After the first batch the loader writes into the same buffers, including
+  // the short tail batch and the next epoch.
+  DataLoader loader(ds, 16, true);
+  ASSERT_TRUE(loader.next(X, Y));
+  const float *px = X.data.data();
+  const float *py = Y.data.data();
+  for (int epoch = 0; epoch < 2; ++epoch) {
+    while (loader.next(X, Y)) {
+      ASSERT_TRUE(X.data.data() == px);
+      ASSERT_TRUE(Y.data.data() == py);
+    }
+    loader.reset();
+  }
+}
+
+namespace {
+
+// Runs both loaders through three epochs (abandoning the middle one half
+// way, with batches in flight) and checks they produce identical batches.
+void expect_same_batches(DataLoader &sync, DataLoader &async) {
+  Tensor X, Y, PX, PY;
+  for (int epoch = 0; epoch < 3; ++epoch) {
+    size_t limit = epoch == 1 ? sync.len() / 2 : sync.len();
+    for (size_t b = 0; b < limit; ++b) {
+      ASSERT_TRUE(sync.next(X, Y));
+      ASSERT_TRUE(async.next(PX, PY));
+      ASSERT_EQ(PX.rows, X.rows);
+      for (size_t i = 0; i < X.size(); ++i)
+        ASSERT_EQ(PX.data[i], X.data[i]);
+      for (size_t i = 0; i < Y.size(); ++i)
+        ASSERT_EQ(PY.data[i], Y.data[i]);
+    }
+    if (epoch != 1) {
+      ASSERT_TRUE(!sync.next(X, Y));
+      ASSERT_TRUE(!async.next(PX, PY));
+    }
+    sync.reset();
+    async.reset();
+  }
+}
+
+}  
+
+void test_dataloader_prefetch_order() {
+  auto ds = make_blobs(203, 3, 4);
+  DataLoader sync(ds, 16, true, 7);
+  LoaderOptions opts;
+  opts.seed = 7;
+  opts.prefetch = 3;
+  DataLoader pre(ds, 16, opts);
+  expect_same_batches(sync, pre);
+
+  const LoaderStats &st = pre.stats();
+  ASSERT_EQ(st.batches, 2 * sync.len() + sync.len() / 2);
+  ASSERT_TRUE(st.stalls <= st.batches);
+}
+
+void test_dataloader_workers_order() {
+  auto ds = make_blobs(517, 5, 3);
+  PerSampleDataset slow(ds);
+  DataLoader sync(slow, 8, true, 11);
+  LoaderOptions opts;
+  opts.seed = 11;
+  opts.num_workers = 4;
+  DataLoader par(slow, 8, opts);
+  expect_same_batches(sync, par);
+}
+
+void test_binary_dataset_roundtrip() {
+  auto ds = make_blobs(300, 5, 3);
+  const Tensor &fx = ds.features();
+  const Tensor &fy = ds.targets();
+  const std::string path = "test_dataset.tnds";
+  {
+    // Streamed in uneven chunks, as a converter would.
+    BinaryDatasetWriter w(path, 5, 3);
+    size_t done = 0;
+    for (size_t chunk : {1, 128, 171}) {
+      w.append(fx.data.data() + done * 5, fy.data.data() + done * 3, chunk);
+      done += chunk;
+    }
+    w.finish();
+    ASSERT_EQ(w.rows(), (size_t)300);
+  }
+
+  MmapDataset mm(path);
+  ASSERT_EQ(mm.size(), (size_t)300);
+  ASSERT_EQ(mm.feature_cols(), 5);
+  ASSERT_EQ(mm.target_cols(), 3);
+  for (size_t i = 0; i < mm.size(); ++i) {
+    Sample s = mm.get(i);
+    for (int j = 0; j < 5; ++j)
+      ASSERT_EQ(s.x(0, j), fx((int)i, j));
+    for (int j = 0; j < 3; ++j)
+      ASSERT_EQ(s.y(0, j), fy((int)i, j));
+  }
+
+  const size_t shuffled[] = {299, 3, 150, 0};
+  Tensor X, Y;
+  mm.get_batch(shuffled, 4, X, Y);
+  ASSERT_TRUE(!X.is_view());
+  for (int k = 0; k < 4; ++k)
+    for (int j = 0; j < 5; ++j)
+      ASSERT_EQ(X(k, j), fx((int)shuffled[k], j));
+
+  // Consecutive rows are copied by default, into the caller's buffers.
+  const size_t run[] = {10, 11, 12, 13};
+  const float *buf = X.data.data();
+  mm.get_batch(run, 4, X, Y);
+  ASSERT_TRUE(!X.is_view() && X.data.data() == buf);
+
+  // With zero-copy, an unshuffled loader gets views of the mapping.
+  mm.set_zero_copy(true);
+  DataLoader loader(mm, 64, false);
+  size_t row = 0;
+  while (loader.next(X, Y)) {
+    ASSERT_TRUE(X.is_view() && Y.is_view());
+    for (int k = 0; k < X.rows; ++k, ++row) {
+      ASSERT_EQ(X(k, 4), fx((int)row, 4));
+      ASSERT_EQ(Y(k, 2), fy((int)row, 2));
+    }
+  }
+  ASSERT_EQ(row, (size_t)300);
+
+  // Writes through a view stay private to this mapping.
+  mm.get_batch(run, 4, X, Y);
+  X(0, 0) = -1.0f;
+  ASSERT_EQ(MmapDataset(path).get(10).x(0, 0), fx(10, 0));
+  // Views must not outlive (or be written after) a rewrite of the file.
+  X.rebind(Tensor());
+  Y.rebind(Tensor());
+
+  // u8 features with a fused scale/bias on read.
+  Tensor px(50, 4);
+  Tensor py(50, 1);
+  RNG rng(3);
+  for (auto &v : px.data)
+    v = rng.uniform(-1.0f, 1.0f);
+  save_binary_dataset(TensorDataset(px, py), path, DType::U8, 2.0f / 255.0f,
+                      -1.0f);
+  MmapDataset q(path);
+  ASSERT_TRUE(q.feature_dtype() == DType::U8);
+  const size_t all[] = {0, 1, 2, 3, 4};
+  q.get_batch(all, 5, X, Y);
+  for (int k = 0; k < 5; ++k)
+    for (int j = 0; j < 4; ++j)
+      ASSERT_NEAR(X(k, j), px(k, j), 1.01f / 255.0f);
+
+  std::remove(path.c_str());
+}
+
+namespace {
+
+// Records will_need hints on top of an in-memory dataset. Loader workers
+// hint concurrently, so the log is guarded.
+struct HintedDataset : PerSampleDataset {
+  mutable std::mutex mu;
+  mutable std::vector<size_t> hinted;
+  using PerSampleDataset::PerSampleDataset;
+  void will_need(size_t begin, size_t n) const override {
+    std::lock_guard<std::mutex> lock(mu);
+    hinted.push_back(begin);
+    (void)n;
+  }
+};
+
+}  
+
+void test_dataloader_block_shuffle() {
+  auto ds = make_blobs(1000, 2, 2);
+  HintedDataset hinted(ds);
+  LoaderOptions opts;
+  opts.seed = 5;
+  opts.shuffle_block = 64;
+  opts.shuffle_window = 4;
+  DataLoader loader(hinted, 1000, opts);
+
+  // One batch covering the epoch exposes the order through the features.
+  Tensor X, Y;
+  ASSERT_TRUE(loader.next(X, Y));
+  std::vector<size_t> order;
+  for (int k = 0; k < X.rows; ++k) {
+    for (size_t r = 0; r < ds.size(); ++r)
+      if (ds.features()((int)r, 0) == X(k, 0) &&
+          ds.features()((int)r, 1) == X(k, 1)) {
+        order.push_back(r);
+        break;
+      }
+  }
+  ASSERT_EQ(order.size(), (size_t)1000);
+
+  // A permutation, not the identity, and every window of 4 * 64 rows draws
+  // from exactly 4 blocks.
+  std::vector<int> seen(1000, 0);
+  size_t moved = 0;
+  for (size_t i = 0; i < order.size(); ++i) {
+    seen[order[i]]++;
+    moved += order[i] != i;
+  }
+  for (int c : seen)
+    ASSERT_EQ(c, 1);
+  ASSERT_TRUE(moved > 500);
+  for (size_t w = 0; w + 256 <= 768; w += 256) {
+    std::vector<size_t> blocks;
+    for (size_t i = w; i < w + 256; ++i)
+      blocks.push_back(order[i] / 64);
+    std::sort(blocks.begin(), blocks.end());
+    blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+    ASSERT_EQ(blocks.size(), (size_t)4);
+  }
+  ASSERT_TRUE(hinted.hinted.size() >= 8); // windows 0 and 1 up front
+
+  // Reproducible from the seed, including with background workers.
+  LoaderOptions sync_opts = opts;
+  DataLoader a(hinted, 50, sync_opts);
+  LoaderOptions par_opts = opts;
+  par_opts.num_workers = 3;
+  DataLoader b(hinted, 50, par_opts);
+  expect_same_batches(a, b);
+}
+
+void test_compact_dataset() {
+  // Every finite half survives a round trip through fp32 bit-exactly.
+  for (uint32_t h = 0; h < 0x10000u; ++h) {
+    if ((h & 0x7c00u) == 0x7c00u && (h & 0x3ffu))
+      continue; // NaN payloads
+    ASSERT_EQ(f32_to_f16(f16_to_f32((uint16_t)h)), (uint16_t)h);
+  }
+  ASSERT_EQ(f16_to_f32(f32_to_f16(65504.0f)), 65504.0f);
+  ASSERT_EQ(f32_to_f16(1e6f), (uint16_t)0x7c00u);
+  ASSERT_EQ(f16_to_f32(f32_to_f16(1.0f + 1.0f / 4096.0f)), 1.0f); // ties even
+
+  auto ds = make_blobs(400, 6, 3);
+  const Tensor &fx = ds.features();
+  std::vector<size_t> idx(ds.size());
+  for (size_t i = 0; i < idx.size(); ++i)
+    idx[i] = (i * 37) % idx.size();
+
+  for (DType dt : {DType::U8, DType::I16, DType::F16}) {
+    CompactDataset cd = CompactDataset::quantize(fx, ds.targets(), dt);
+    ASSERT_EQ(cd.size(), ds.size());
+    ASSERT_TRUE(cd.feature_bytes() <=
+                fx.size() * dtype_size(dt) + fx.cols * 2 * sizeof(float));
+
+    Tensor X, Y;
+    cd.get_batch(idx.data(), idx.size(), X, Y);
+    for (size_t k = 0; k < idx.size(); ++k) {
+      for (int j = 0; j < fx.cols; ++j) {
+        const float ref = fx((int)idx[k], j);
+        const float tol = dt == DType::F16 ? std::fabs(ref) / 2048.0f
+                                           : cd.scale()[j] * 0.51f;
+        ASSERT_NEAR(X((int)k, j), ref, tol + 1e-6f);
+      }
+      ASSERT_EQ(Y((int)k, 1), ds.targets()((int)idx[k], 1));
+    }
+    Sample s = cd.get(idx[5]);
+    ASSERT_EQ(s.x(0, 3), X(5, 3));
+  }
+
+  // Raw u8 pixels with a fused per-column normalization.
+  std::vector<uint8_t> pixels = {0, 255, 128, 10, 20, 30};
+  Tensor labels(2, 1);
+  CompactDataset px(DType::U8, 2, 3, pixels, labels,
+                    {1.0f / 255.0f, 2.0f / 255.0f, 1.0f},
+                    {0.0f, -1.0f, -128.0f});
+  Tensor X, Y;
+  const size_t both[] = {0, 1};
+  px.get_batch(both, 2, X, Y);
+  ASSERT_NEAR(X(0, 0), 0.0f, 1e-6f);
+  ASSERT_NEAR(X(0, 1), 1.0f, 1e-6f);
+  ASSERT_NEAR(X(0, 2), 0.0f, 1e-6f);
+  ASSERT_NEAR(X(1, 1), 40.0f / 255.0f - 1.0f, 1e-6f);
+}
+
+void test_stream_loader() {
+  // Row i carries i in both x and y, so the emitted order is observable.
+  const int total = 1003;
+  int produced = 0;
+  GeneratorDataset gen(2, 1, [&](float *x, float *y) {
+    if (produced == total)
+      return false;
+    x[0] = (float)produced;
+    x[1] = -(float)produced;
+    y[0] = (float)produced;
+    ++produced;
+    return true;
+  });
+
+  StreamOptions opts;
+  opts.shuffle_buffer = 64;
+  opts.chunk_rows = 17;
+  StreamLoader loader(gen, 10, opts);
+
+  std::vector<int> order;
+  Tensor X, Y;
+  while (loader.next(X, Y)) {
+    ASSERT_TRUE(X.rows <= 10);
+    for (int k = 0; k < X.rows; ++k) {
+      ASSERT_EQ(X(k, 1), -X(k, 0));
+      ASSERT_EQ(Y(k, 0), X(k, 0));
+      order.push_back((int)X(k, 0));
+    }
+  }
+  ASSERT_EQ(order.size(), (size_t)total);
+  ASSERT_EQ(loader.rows_emitted(), (size_t)total);
+
+  // Every row exactly once, shuffled, and never emitted before it could
+  // have entered the 64-row buffer.
+  std::vector<int> seen(total, 0);
+  size_t moved = 0;
+  for (size_t p = 0; p < order.size(); ++p) {
+    seen[order[p]]++;
+    moved += order[p] != (int)p;
+    ASSERT_TRUE(order[p] <= (int)p + 63);
+  }
+  for (int c : seen)
+    ASSERT_EQ(c, 1);
+  ASSERT_TRUE(moved > total / 2);
+
+  // Text records, one-hot labels; buffer of 1 keeps stream order.
+  std::istringstream text("1.5, 2,0\n\n-3,4e-1 , 2\r\n7,8,1");
+  TextStreamDataset lines(text, 2, 3);
+  StreamOptions fifo;
+  fifo.shuffle_buffer = 1;
+  StreamLoader in_order(lines, 2, fifo);
+  ASSERT_TRUE(in_order.next(X, Y));
+  ASSERT_EQ(X.rows, 2);
+  ASSERT_EQ(X(0, 0), 1.5f);
+  ASSERT_NEAR(X(1, 1), 0.4f, 1e-7f);
+  ASSERT_EQ(Y(0, 0), 1.0f);
+  ASSERT_EQ(Y(1, 2), 1.0f);
+  ASSERT_TRUE(in_order.next(X, Y));
+  ASSERT_EQ(X.rows, 1);
+  ASSERT_EQ(X(0, 1), 8.0f);
+  ASSERT_EQ(Y(0, 1), 1.0f);
+  ASSERT_TRUE(!in_order.next(X, Y));
+
+  // Out-of-range, huge and fractional labels are rejected.
+  for (const char *label : {"1e20", "1e39", "-1", "3", "0.5"}) {
+    std::istringstream bad(std::string("1,2,") + label + "\n");
+    TextStreamDataset rows(bad, 2, 3);
+    float xb[2], yb[3];
+    bool threw = false;
+    try {
+      rows.read(xb, yb, 1);
+    } catch (const std::exception &) {
+      threw = true;
+    }
+    ASSERT_TRUE(threw);
+  }
+}
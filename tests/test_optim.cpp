@@ -1,6 +1,18 @@
+#include "core/rng.h"
 #include "core/tensor.h"
+#include "nn/activations.h"
+#include "nn/dense.h"
+#include "nn/sequential.h"
 #include "optim/adam.h"
+#include "optim/adam8bit.h"
+#include "optim/lamb.h"
+#include "optim/lars.h"
+#include "optim/loss_scaler.h"
+#include "optim/param_slots.h"
+#include "optim/sgd.h"
 #include "utils/test_utils.h"
+#include <cmath>
+#include <memory>
 
 using namespace tf;
 
@@ -35,3 +47,212 @@ void test_adam_simple() {
   
   ASSERT_NEAR(x(0, 0), 5.0f, 0.05f);
 }
+
+void test_adamw_matches_reference() {
+  // Two tensors, one larger than a parallel chunk, against the textbook
+  // AdamW update computed in double precision.
+  Tensor a(1, 20000), b(3, 5);
+  Tensor ga(1, 20000), gb(3, 5);
+  for (size_t i = 0; i < a.size(); ++i)
+    a.data[i] = 0.001f * (float)(i % 97) - 0.05f;
+  for (size_t i = 0; i < b.size(); ++i)
+    b.data[i] = 0.1f * (float)i - 0.7f;
+
+  Tensor a0 = a, b0 = b;
+  std::vector<Param> ps = {Param{&a, &ga}, Param{&b, &gb}};
+
+  const float lr = 0.01f, b1 = 0.9f, b2 = 0.999f, eps = 1e-8f, wd = 0.1f;
+  Adam optim(lr, b1, b2, eps, wd);
+
+  std::vector<double> ref, m, v;
+  for (auto *t : {&a0, &b0})
+    for (float x : t->data)
+      ref.push_back(x);
+  m.assign(ref.size(), 0.0);
+  v.assign(ref.size(), 0.0);
+
+  for (int t = 1; t <= 5; ++t) {
+    size_t k = 0;
+    for (auto *g : {&ga, &gb}) {
+      for (size_t i = 0; i < g->size(); ++i, ++k) {
+        g->data[i] = std::sin(0.37f * (float)(k + t));
+        double gi = g->data[i];
+        m[k] = b1 * m[k] + (1 - b1) * gi;
+        v[k] = b2 * v[k] + (1 - b2) * gi * gi;
+        double mh = m[k] / (1 - std::pow(b1, t));
+        double vh = v[k] / (1 - std::pow(b2, t));
+        ref[k] = ref[k] * (1 - lr * wd) - lr * mh / (std::sqrt(vh) + eps);
+      }
+    }
+    optim.step(ps);
+  }
+
+  size_t k = 0;
+  for (auto *t : {&a, &b})
+    for (size_t i = 0; i < t->size(); ++i, ++k)
+      ASSERT_NEAR(t->data[i], (float)ref[k], 1e-5f);
+}
+
+void test_sgd_nesterov_fused_zero_grad() {
+  Tensor w(2, 3), g(2, 3);
+  for (size_t i = 0; i < w.size(); ++i)
+    w.data[i] = 0.5f - 0.2f * (float)i;
+  std::vector<Param> ps = {Param{&w, &g}};
+
+  const float lr = 0.1f, mu = 0.9f, wd = 0.01f;
+  SGD optim(lr, mu, wd, /*nesterov=*/true);
+
+  std::vector<float> ref(w.data.begin(), w.data.end());
+  std::vector<float> buf(ref.size(), 0.0f);
+
+  for (int t = 0; t < 4; ++t) {
+    for (size_t i = 0; i < g.size(); ++i) {
+      g.data[i] = std::cos(0.3f * (float)(i + t));
+      float d = g.data[i] + wd * ref[i];
+      buf[i] = mu * buf[i] + d;
+      ref[i] -= lr * (d + mu * buf[i]);
+    }
+    optim.step(ps, /*zero_grad=*/true);
+    for (size_t i = 0; i < g.size(); ++i)
+      ASSERT_EQ(g.data[i], 0.0f);
+  }
+
+  for (size_t i = 0; i < w.size(); ++i)
+    ASSERT_NEAR(w.data[i], ref[i], 1e-5f);
+}
+
+void test_fused_backward_step() {
+  RNG rng(11);
+  Sequential fused;
+  fused.add(new Dense(4, 6, rng));
+  fused.add(new ReLU());
+  fused.add(new Dense(6, 3, rng));
+  std::unique_ptr<Module> reference(fused.clone());
+
+  auto ps = fused.params();
+  auto ref_ps = reference->params();
+
+  Tensor x(5, 4), g(5, 3);
+  for (size_t i = 0; i < x.size(); ++i)
+    x.data[i] = std::sin((float)i);
+  for (size_t i = 0; i < g.size(); ++i)
+    g.data[i] = 0.1f * std::cos((float)i);
+
+  Adam fused_optim(0.01f), ref_optim(0.01f);
+  for (int step = 0; step < 3; ++step) {
+    fused.forward(x);
+    fused.backward_step(g, fused_optim, /*drop_grads=*/step == 2);
+
+    ref_optim.zero_grad(ref_ps);
+    reference->forward(x);
+    reference->backward(g);
+    ref_optim.step(ref_ps);
+  }
+
+  for (size_t p = 0; p < ps.size(); ++p) {
+    ASSERT_EQ(ps[p].grad->size(), (size_t)0);
+    for (size_t i = 0; i < ps[p].value->size(); ++i)
+      ASSERT_NEAR(ps[p].value->data[i], ref_ps[p].value->data[i], 1e-6f);
+  }
+}
+
+void test_param_slots_bindings() {
+  // Per-layer lists bound in turn keep their bindings and offsets.
+  Tensor w1(3, 4), g1(3, 4), w2(2, 2), g2(2, 2);
+  std::vector<Param> a = {{&w1, &g1}}, b = {{&w2, &g2}};
+  ParamSlots slots;
+  ASSERT_TRUE(slots.bind(a));
+  const size_t off_a = slots.offset(0);
+  ASSERT_TRUE(slots.bind(b));
+  const size_t off_b = slots.offset(0);
+  for (int step = 0; step < 3; ++step) {
+    ASSERT_TRUE(!slots.bind(a));
+    ASSERT_EQ(slots.offset(0), off_a);
+    ASSERT_EQ(slots.chunks().size(), (size_t)1);
+    ASSERT_TRUE(!slots.bind(b));
+    ASSERT_EQ(slots.offset(0), off_b);
+  }
+
+  // Fresh lists each step don't grow the cache without bound, and evicted
+  // lists come back with their old offsets.
+  std::vector<Tensor> ws(40, Tensor(1, 4)), gs(40, Tensor(1, 4));
+  for (size_t i = 0; i < ws.size(); ++i)
+    for (size_t j = i + 1; j < ws.size(); ++j) {
+      std::vector<Param> pair = {{&ws[i], &gs[i]}, {&ws[j], &gs[j]}};
+      slots.bind(pair);
+      ASSERT_TRUE(!slots.bind(a));
+    }
+  ASSERT_TRUE(slots.num_bindings() <= ParamSlots::kMaxBindings);
+  ASSERT_EQ(slots.offset(0), off_a);
+  ASSERT_TRUE(!slots.bind(b));
+  ASSERT_EQ(slots.offset(0), off_b);
+
+  // A released gradient is skipped, and picked up again once re-created.
+  g1 = Tensor();
+  ASSERT_TRUE(!slots.bind(a));
+  ASSERT_EQ(slots.offset(0), ParamSlots::npos);
+  g1 = Tensor(3, 4);
+  ASSERT_TRUE(!slots.bind(a));
+  ASSERT_EQ(slots.offset(0), off_a);
+
+  // LossScaler refuses gradients released by backward_step.
+  g2 = Tensor();
+  LossScaler scaler;
+  bool threw = false;
+  try {
+    scaler.unscale(b);
+  } catch (const std::exception &) {
+    threw = true;
+  }
+  ASSERT_TRUE(threw);
+}
+
+void test_lamb_lars_trust_ratio() {
+  // ||w|| = 5, g = (1, -1). On the first LAMB step r = sign(g), so the
+  // trust ratio is 5 / sqrt(2); for LARS it is eta * 5 / ||g||.
+  Tensor w(1, 2), g(1, 2);
+  std::vector<Param> ps = {Param{&w, &g}};
+  const float ratio = 5.0f / std::sqrt(2.0f);
+
+  w(0, 0) = 3.0f; w(0, 1) = 4.0f;
+  g(0, 0) = 1.0f; g(0, 1) = -1.0f;
+  LAMB lamb(0.1f);
+  lamb.step(ps);
+  ASSERT_NEAR(lamb.trust_ratios()[0], ratio, 1e-4f);
+  ASSERT_NEAR(w(0, 0), 3.0f - 0.1f * ratio, 1e-4f);
+  ASSERT_NEAR(w(0, 1), 4.0f + 0.1f * ratio, 1e-4f);
+
+  w(0, 0) = 3.0f; w(0, 1) = 4.0f;
+  LARS lars(0.1f, 0.9f, 0.0f, 0.01f);
+  lars.step(ps, /*zero_grad=*/true);
+  ASSERT_NEAR(lars.trust_ratios()[0], 0.01f * ratio, 1e-6f);
+  ASSERT_NEAR(w(0, 0), 3.0f - 0.1f * 0.01f * ratio, 1e-6f);
+  ASSERT_EQ(g(0, 0), 0.0f);
+}
+
+void test_adam8bit_tracks_adam() {
+  const int n = 1000;
+  Tensor target(1, n);
+  for (int i = 0; i < n; ++i)
+    target.data[i] = 3.0f * std::sin(0.1f * (float)i) + 0.01f * (float)(i % 7);
+
+  Tensor a(1, n), ga(1, n), q(1, n), gq(1, n);
+  std::vector<Param> pa = {Param{&a, &ga}}, pq = {Param{&q, &gq}};
+  Adam adam(0.05f);
+  Adam8bit adam8(0.05f);
+
+  for (int step = 0; step < 300; ++step) {
+    for (int i = 0; i < n; ++i) {
+      ga.data[i] = 2.0f * (a.data[i] - target.data[i]);
+      gq.data[i] = 2.0f * (q.data[i] - target.data[i]);
+    }
+    adam.step(pa);
+    adam8.step(pq);
+  }
+
+  for (int i = 0; i < n; ++i) {
+    ASSERT_NEAR(q.data[i], target.data[i], 0.05f);
+    ASSERT_NEAR(q.data[i], a.data[i], 0.05f);
+  }
+  ASSERT_TRUE(adam8.state_bytes() * 3 < adam.state_bytes());
+}
@@ -0,0 +1,43 @@
+#include "core/rng.h"
+#include "data/toy_datasets.h"
+#include "nn/activations.h"
+#include "nn/data_parallel.h"
+#include "nn/dense.h"
+#include "nn/losses.h"
+#include "nn/sequential.h"
+#include "utils/test_utils.h"
+
+using namespace tf;
+
+void test_data_parallel_matches_serial() {
+  auto ds = make_blobs(10, 4, 3);
+  const Tensor &X = ds.features();
+  const Tensor &Y = ds.targets();
+
+  RNG rng(7);
+  Sequential model;
+  model.add(new Dense(4, 8, rng));
+  model.add(new ReLU());
+  model.add(new Dense(8, 3, rng));
+
+  std::unique_ptr<Module> reference(model.clone());
+
+  Tensor logits = reference->forward(X);
+  Tensor d_logits;
+  float ref_loss = softmax_cross_entropy_with_logits(logits, Y, d_logits);
+  reference->backward(d_logits);
+
+  DataParallel dp(model, 3);
+  float loss = dp.forward_backward(X, Y, softmax_cross_entropy_with_logits);
+
+  ASSERT_NEAR(loss, ref_loss, 1e-5f);
+
+  auto ps = model.params();
+  auto ref_ps = reference->params();
+  ASSERT_EQ(ps.size(), ref_ps.size());
+  for (size_t p = 0; p < ps.size(); ++p) {
+    for (size_t i = 0; i < ps[p].grad->size(); ++i) {
+      ASSERT_NEAR(ps[p].grad->data[i], ref_ps[p].grad->data[i], 1e-5f);
+    }
+  }
+}
@@ -0,0 +1,45 @@
+// Folds a chain of delta checkpoints into a single full snapshot, so the
+// earlier files of the chain can be deleted.
+//
+//   ckpt_compact input.tnn output.tnn
+//
+// input.tnn is the newest file of the chain; its parents are found through
+// the paths recorded in each delta.
+#include "io/delta_checkpoint.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace tf;
+
+static size_t file_size(const std::string& path) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  return in ? (size_t)in.tellg() : 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "usage: ckpt_compact input.tnn output.tnn\n";
+    return 1;
+  }
+
+  try {
+    auto chain = checkpoint_chain(argv[1]);
+    size_t chain_bytes = 0;
+    for (const auto& f : chain) {
+      std::cout << "  " << f << " (" << file_size(f) << " bytes)\n";
+      chain_bytes += file_size(f);
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    compact_checkpoint(argv[1], argv[2]);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Compacted " << chain.size() << " files (" << chain_bytes << " bytes) into "
+              << argv[2] << " (" << file_size(argv[2]) << " bytes) in " << secs << " s" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << "ckpt_compact: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+// Converts a numeric CSV file to the binary dataset format read by
+// MmapDataset, streaming with bounded memory.
+//
+//   csv2tnds input.csv output.tnds [--classes N] [--label NAME|INDEX]
+//            [--no-header] [--delimiter C] [--u8 SCALE BIAS]
+//            [--chunk-mb N] [--threads N]
+#include "data/csv.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using namespace tf;
+
+static void usage() {
+  std::cerr << "usage: csv2tnds input.csv output.tnds [--classes N] [--label NAME|INDEX]\n"
+               "                [--no-header] [--delimiter C] [--u8 SCALE BIAS]\n"
+               "                [--chunk-mb N] [--threads N]\n";
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    usage();
+    return 1;
+  }
+
+  CsvOptions opts;
+  DType dtype = DType::F32;
+  float scale = 1.0f, bias = 0.0f;
+
+  for (int i = 3; i < argc; ++i) {
+    std::string a = argv[i];
+    bool has_value = i + 1 < argc;
+    if (a == "--classes" && has_value) {
+      opts.num_classes = std::atoi(argv[++i]);
+    } else if (a == "--label" && has_value) {
+      std::string v = argv[++i];
+      char* end = nullptr;
+      long idx = std::strtol(v.c_str(), &end, 10);
+      if (*end == '\0')
+        opts.label_column = (int)idx;
+      else
+        opts.label_name = v;
+    } else if (a == "--no-header") {
+      opts.has_header = false;
+    } else if (a == "--delimiter" && has_value) {
+      opts.delimiter = argv[++i][0];
+    } else if (a == "--u8" && i + 2 < argc) {
+      dtype = DType::U8;
+      scale = std::strtof(argv[++i], nullptr);
+      bias = std::strtof(argv[++i], nullptr);
+    } else if (a == "--chunk-mb" && has_value) {
+      opts.chunk_bytes = (size_t)std::atoi(argv[++i]) << 20;
+    } else if (a == "--threads" && has_value) {
+      opts.num_threads = (size_t)std::atoi(argv[++i]);
+    } else {
+      usage();
+      return 1;
+    }
+  }
+
+  try {
+    auto t0 = std::chrono::steady_clock::now();
+    size_t rows = csv_to_binary(argv[1], argv[2], opts, dtype, scale, bias);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Wrote " << rows << " rows to " << argv[2] << " in " << secs << " s" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << "csv2tnds: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}